@@ -11,7 +11,42 @@
  *  arm_book_lib.h          : Includes & definitions to help develop proyects from the book.
  *  compile_commands.json   : Compile commands.
  *  main.cpp                : Main program.
+ *  modules/                : Reusable services used by the main program.
+ *      matrix_keypad/      : 4x4 keypad scanned from a ticker interrupt, with key events.
+ *      tick_clock/         : Real or virtual time source of the control loop ticks.
+ *      simulated_inputs/   : Seeded, replayable temperature, gas and keypad scenario.
+ *      timer_wheel/        : Hierarchical timer wheel for periodic and one-shot timeouts.
+ *      protothread/        : Stackless cooperative threads used by the UART dialogs.
+ *      lockfree_queue/     : Lock-free SPSC and MPSC queues from interrupts to tasks.
+ *      object_pool/        : Fixed-block pools for short-lived objects.
+ *      heap_guard/         : Detection of heap allocations after initialization.
+ *      delta_codec/        : Delta-of-delta zigzag varint codec for time series.
+ *      sample_history/     : Compressed history of the voted temperature.
+ *      cycle_counter/      : DWT CPU cycle counter for benchmarks.
+ *      benchmark/          : Cycles per call of functions, for the benchmark mode.
+ *      trace/              : Ring of timestamped begin/end events of the tasks and ISRs.
+ *      rollup/             : Temperature min/max/mean per second, minute and hour.
+ *      kalman_filter/      : Fixed-point temperature and rate estimate of the LM35.
+ *      moving_average/     : Moving average of raw 16-bit ADC counts.
+ *      sensor_fault/       : Plausibility checks (range, stuck, rate) of analog sensors.
+ *      temperature_voter/  : M-out-of-N voting among redundant temperature sensors.
+ *      i2c_scheduler/      : Queue of asynchronous I2C transfers, real and simulated bus.
+ *      tmp117/             : TMP117 digital temperature sensor driver.
+ *      character_lcd/      : HD44780 LCD on a PCF8574 I2C backpack, updated cell by cell.
+ *      status_report/      : Whole device state as one compact binary record.
+ *      shared_state/       : Seqlock publishing the device state to its readers.
+ *      network/            : Ethernet interface shared by the network modules.
+ *      udp_endpoint/       : Ethernet UDP status queries and telemetry.
+ *      mqtt_publisher/     : MQTT alarm events and batched temperature readings.
  *  mbed-os.lib             : Mbed repository.
+ *  mbed_app.json           : Mbed configuration, including the memory budgets.
+ *  .github/workflows/      : CI build with the memory budget check, and host checks.
+ *  tests/host/             : Host checks of the modules (make -C tests/host check).
+ *  tools/memory_report.py  : Per-module and per-symbol RAM/flash report of the linker map.
+ *  tools/benchmark_run.py  : Runs the benchmark mode under Renode and collects the counts.
+ *  tools/benchmark_check.py: Compares benchmark counts against a baseline.
+ *  tools/renode/           : Renode script of the emulated NUCLEO-F429ZI.
+ *  tools/trace_convert.py  : Converts a trace dump to Chrome trace JSON (Perfetto).
  *
  */
 
@@ -19,9 +54,36 @@
 
 #include "mbed.h"
 #include "arm_book_lib.h"
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "benchmark.h"
+#include "character_lcd.h"
+#include "cycle_counter.h"
+#include "heap_guard.h"
+#include "i2c_bus.h"
+#include "i2c_scheduler.h"
+#include "kalman_filter.h"
+#include "lockfree_queue.h"
+#include "matrix_keypad.h"
+#include "moving_average.h"
+#include "mqtt_publisher.h"
+#include "network.h"
+#include "protothread.h"
+#include "rollup.h"
+#include "sample_history.h"
+#include "sensor_fault.h"
+#include "shared_state.h"
+#include "simulated_inputs.h"
+#include "status_report.h"
+#include "temperature_voter.h"
+#include "tick_clock.h"
+#include "tmp117.h"
+#include "trace.h"
+#include "udp_endpoint.h"
+#include "timer_wheel.h"
+
 //=====[Defines]===============================================================
 
 #define NUMBER_OF_KEYS                           4
@@ -30,18 +92,156 @@
 #define BLINKING_TIME_GAS_AND_OVER_TEMP_ALARM  100
 #define NUMBER_OF_AVG_SAMPLES                   100
 #define OVER_TEMP_LEVEL                         50
-#define TIME_INCREMENT_MS                       10
+#define OVER_TEMP_LEVEL_MIN                     20
+#define OVER_TEMP_LEVEL_MAX                     80
+#define POTENTIOMETER_SAMPLING_TIME            100
+#define POTENTIOMETER_FILTER_SHIFT               4
+#define TIME_INCREMENT_MS                       TIMER_WHEEL_TICK_MS
+#define MQTT_READING_PERIOD                     MBED_CONF_APP_MQTT_READING_PERIOD_MS
+#define UART_RX_BUFFER_SIZE                     64
+#define UART_TX_BUFFER_SIZE                    256
+#define UART_COMMANDS_PER_TICK                  16
+#define UART_BAUD_RATE                          MBED_CONF_APP_CONSOLE_BAUD_RATE
+#define UART_AUTO_BAUD_SYNC                     '\r'
+#define UART_BAUD_CONFIRM_CHAR                  'y'
+#define UART_BITS_PER_CHAR                      10
+#define UART_BAUD_CONFIRM_TIME                5000
+#define UART_THROUGHPUT_TEST_BYTES            8192
+#define MEMORY_REPORT_MAX_THREADS                 8
+#define HISTORY_SAMPLING_TIME                 1000
+#define HISTORY_REPORT_LINE_SIZE                24
+#define HISTORY_REPORT_LINES_PER_CALL           ( UART_TX_BUFFER_SIZE / \
+                                                  HISTORY_REPORT_LINE_SIZE )
+#define ROLLUP_REPORT_LINE_SIZE                 64
+#define ROLLUP_REPORT_LINES_PER_CALL            ( UART_TX_BUFFER_SIZE / \
+                                                  ROLLUP_REPORT_LINE_SIZE )
+#define LCD_REFRESH_TIME                       250
+#define ADAPTIVE_SAMPLING                       MBED_CONF_APP_ADAPTIVE_SAMPLING
+#define VIRTUAL_CLOCK                           MBED_CONF_APP_VIRTUAL_CLOCK
+#define BENCHMARK                               MBED_CONF_APP_BENCHMARK
+#define BENCHMARK_ITERATIONS                    100
+#define SIMULATED_INPUTS_SEED                   MBED_CONF_APP_SIMULATED_INPUTS_SEED
+#define KALMAN_FILTER                           MBED_CONF_APP_KALMAN_FILTER
+#define KALMAN_PROCESS_NOISE                    MBED_CONF_APP_KALMAN_PROCESS_NOISE
+#define KALMAN_MEASUREMENT_NOISE                MBED_CONF_APP_KALMAN_MEASUREMENT_NOISE
+#define SAMPLING_SLOWDOWN_TIME                5000
+#define SENSOR_CHECK_TIME                     1000
+#define LM35_MIN_PLAUSIBLE_TEMP                  2
+#define LM35_MAX_PLAUSIBLE_TEMP                150
+#define LM35_MAX_TEMP_CHANGE                    10
+#define ADC_LSB_COUNTS                          16
+#define LM35_STUCK_VARIANCE       ( ADC_LSB_COUNTS * ADC_LSB_COUNTS / 16 )
+#define SENSOR_STUCK_TIME                    30000
+#define MQ2_MAX_TRANSITIONS                     10
+#define INTERNAL_TEMP_MIN_PLAUSIBLE            -40
+#define INTERNAL_TEMP_MAX_PLAUSIBLE            125
+#define TMP117_MIN_PLAUSIBLE_TEMP              -55
+#define TMP117_MAX_PLAUSIBLE_TEMP              150
+#define TMP117_SAMPLING_TIME                   100
+#define TMP117_SIMULATED                        ( SIMULATED_INPUTS_SEED && \
+                                          !MBED_CONF_APP_I2C_SIMULATED_BUS )
+#define TEMPERATURE_SENSORS           MBED_CONF_APP_TEMPERATURE_SENSORS
+#define TEMPERATURE_VOTES_REQUIRED    MBED_CONF_APP_TEMPERATURE_VOTES_REQUIRED
+#define TEMPERATURE_TOLERANCE         MBED_CONF_APP_TEMPERATURE_TOLERANCE
+#define TEMPERATURE_FAIL_SAFE         MBED_CONF_APP_TEMPERATURE_FAIL_SAFE
+
+// Temperature (C) to raw LM35 counts: 10 mV/C over a 3.3 V full scale.
+#define LM35_TEMP_TO_COUNTS( temp ) \
+    ( (uint16_t)( ( temp ) * 0.01 / 3.3 * MOVING_AVERAGE_FULL_SCALE ) )
+
+// Temperature (C) to raw counts of the MCU internal sensor, using the typical
+// values of the STM32F4 datasheet: 0.76 V at 25 C and 2.5 mV/C.
+#define INTERNAL_TEMP_TO_COUNTS( temp ) \
+    ( (uint16_t)( ( 0.76 + ( ( temp ) - 25 ) * 0.0025 ) / 3.3 * \
+                  MOVING_AVERAGE_FULL_SCALE ) )
+
+// Temperature (C) to TMP117 counts: 1/128 C per count, offset by half the
+// scale so that the signed reading fits the unsigned filter.
+#define TMP117_TEMP_TO_COUNTS( temp ) \
+    ( (uint16_t)( ( temp ) * 128 + 32768 ) )
+
+#define TEMPERATURE_SENSOR_LM35             0x01
+#define TEMPERATURE_SENSOR_LM35_REDUNDANT   0x02
+#define TEMPERATURE_SENSOR_INTERNAL         0x04
+#define TEMPERATURE_SENSOR_TMP117           0x08
+
+static_assert( ( TEMPERATURE_SENSORS & TEMPERATURE_SENSOR_LM35 ) &&
+               TEMPERATURE_SENSORS < 0x10,
+               "temperature-sensors must include the LM35 (bit 0)" );
+static_assert( !!( TEMPERATURE_SENSORS & TEMPERATURE_SENSOR_LM35 ) +
+               !!( TEMPERATURE_SENSORS & TEMPERATURE_SENSOR_LM35_REDUNDANT ) +
+               !!( TEMPERATURE_SENSORS & TEMPERATURE_SENSOR_INTERNAL ) +
+               !!( TEMPERATURE_SENSORS & TEMPERATURE_SENSOR_TMP117 ) <=
+               TEMPERATURE_VOTER_MAX_CHANNELS,
+               "temperature-sensors selects more sensors than the voter takes" );
+
+#if !MBED_CONF_APP_I2C_SIMULATED_BUS && !DEVICE_I2C_ASYNCH
+#error "The target has no asynchronous I2C: set i2c-simulated-bus"
+#endif
+
+//=====[Declaration of private data types]=====================================
+
+// @note Every sensor gives raw 16-bit counts to its filter and converts the
+// normalized average with its own formula. The sensors selected by the
+// "temperature-sensors" bit mask (see mbed_app.json) take part in the vote,
+// the LM35 on A1 always being the first one.
+typedef struct {
+    const char * name;
+    uint16_t (*rawRead)();
+    bool (*isPresent)();
+    float (*formula)( float analogReading );
+    const analogSensorLimits_t * limits;
+    movingAverage_t readingsFilter;
+    uint8_t faults;
+    uint8_t reportedFaults;
+    uint16_t previousAverage;
+    bool previousAverageValid;
+    int stuckChecks;
+    bool filterSeeded;
+} temperatureSensor_t;
+
+// @note Temperature acquisition modes, slowest first. A mode is used while
+// the voted temperature is closer than marginC to the over temperature level
+// (or above it), or changes faster than slopeCPerS; the fastest mode that
+// applies wins. Faster modes also use shorter filter windows, in time, so
+// the reading reacts sooner near the threshold.
+typedef struct {
+    int periodMs;
+    int windowSamples;
+    float marginC;
+    float slopeCPerS;
+} samplingMode_t;
+
+#if BENCHMARK
+
+typedef struct {
+    const char * name;
+    benchmarkFunction_t function;
+} benchmarkCase_t;
+
+// @note The alarm state the alarm benchmarks change, restored after each
+// benchmark so that the control loop starts from the state it had.
+typedef struct {
+    bool alarmState;
+    bool overTempDetector;
+    bool gasDetectorState;
+    bool overTempDetectorState;
+    int numberOfIncorrectCodes;
+    int numberOfKeysPressed;
+    char keysPressed[NUMBER_OF_KEYS];
+    int mq2Transitions;
+    int alarmLed;
+    int incorrectCodeLed;
+    int systemBlockedLed;
+} alarmStateSnapshot_t;
+
+#endif
 
 //=====[Declaration and initialization of public global objects]===============
 
 // @note DigitalIn / DigitalOut classes analysed in 'Example 1.1'
 
-DigitalIn enterButton(BUTTON1);
 DigitalIn alarmTestButton(D2);
-DigitalIn aButton(D4);
-DigitalIn bButton(D5);
-DigitalIn cButton(D6);
-DigitalIn dButton(D7);
 DigitalIn mq2(PE_12);
 
 DigitalOut alarmLed(LED1);
@@ -51,7 +251,7 @@ DigitalOut systemBlockedLed(LED2);
 DigitalInOut sirenPin(PE_10); // @note Class DigitalInOut allows for easy switch between In & Out in the same switch. Using methods input() and output() one can select the Pin Mode
 
 // @note Constructor implemented in "/home/studio/workspace/example-3.5-tp_03/mbed-os/drivers/include/drivers/UnbufferedSerial.h"
-UnbufferedSerial uartUsb(USBTX, USBRX, 115200); // Default baudrate: 9600
+UnbufferedSerial uartUsb(USBTX, USBRX, UART_BAUD_RATE); // Default baudrate: 9600
 /* UART methods used
 *   readable()  : Determines if there is a character available to read (/home/studio/workspace/example-3.5-tp_03/mbed-os/drivers/include/drivers/SerialBase.h)
 *   read()      : Method to read recieved n bytes and returns # of bytes read.
@@ -67,6 +267,8 @@ UnbufferedSerial uartUsb(USBTX, USBRX, 115200); // Default baudrate: 9600
 // @note Class Constuctor "/home/studio/workspace/example-3.5-tp_03/mbed-os/drivers/include/drivers/AnalogIn.h"
 AnalogIn potentiometer(A0);
 AnalogIn lm35(A1);
+AnalogIn lm35Redundant(A2);
+AnalogIn internalTempSensor(ADC_TEMP);
 
 //=====[Declaration and initialization of public global variables]=============
 
@@ -75,19 +277,124 @@ bool incorrectCode = false;
 bool overTempDetector = OFF;
 
 int numberOfIncorrectCodes = 0;
-int buttonBeingCompared    = 0;
-int codeSequence[NUMBER_OF_KEYS]   = { 1, 1, 0, 0 };
-int buttonsPressed[NUMBER_OF_KEYS] = { 0, 0, 0, 0 };
-int accumulatedTimeAlarm = 0;
+int keyBeingEntered        = 0;
+char codeSequence[NUMBER_OF_KEYS] = { '1', '8', '0', '5' };
+char keysPressed[NUMBER_OF_KEYS]  = { 0, 0, 0, 0 };
+int numberOfKeysPressed           = 0;
 
 bool gasDetectorState          = OFF;
 bool overTempDetectorState     = OFF;
 
 float potentiometerReading = 0.0;
+int overTempLevel          = OVER_TEMP_LEVEL;
+bool potentiometerThresholdTuning = OFF;
 float lm35ReadingsAverage  = 0.0;
-float lm35ReadingsSum      = 0.0;
-float lm35ReadingsArray[NUMBER_OF_AVG_SAMPLES];
 float lm35TempC            = 0.0;
+float lm35TempRateCPerS    = 0.0;
+
+uint8_t temperatureFaults  = SENSOR_FAULT_NONE;
+uint8_t mq2Faults          = SENSOR_FAULT_NONE;
+temperatureVote_t temperatureVoteResult;
+
+//=====[Declaration and initialization of private global variables]============
+
+static timerWheelTimer_t alarmBlinkTimer;
+static timerWheelTimer_t potentiometerSamplingTimer;
+
+// Exponential average of the potentiometer counts, scaled by
+// 2^POTENTIOMETER_FILTER_SHIFT to keep the fractional part.
+static uint32_t potentiometerFilterState = 0;
+
+// @note One step of the 12-bit ADC is ADC_LSB_COUNTS read_u16() counts, and
+// the STM32F4 ADC shows about one step rms of noise on a steady input. The
+// stuck limit (in counts^2) is a quarter of a step rms: a window below it
+// holds nearly the same code on every sample. A quiet sensor can do that for
+// one short window, so the fault is only raised once it lasts
+// SENSOR_STUCK_TIME.
+static const analogSensorLimits_t lm35Limits = {
+    LM35_TEMP_TO_COUNTS( LM35_MIN_PLAUSIBLE_TEMP ),
+    LM35_TEMP_TO_COUNTS( LM35_MAX_PLAUSIBLE_TEMP ),
+    LM35_STUCK_VARIANCE,
+    LM35_TEMP_TO_COUNTS( LM35_MAX_TEMP_CHANGE ),
+};
+
+static const analogSensorLimits_t internalTempLimits = {
+    INTERNAL_TEMP_TO_COUNTS( INTERNAL_TEMP_MIN_PLAUSIBLE ),
+    INTERNAL_TEMP_TO_COUNTS( INTERNAL_TEMP_MAX_PLAUSIBLE ),
+    LM35_STUCK_VARIANCE,
+    (uint16_t)( INTERNAL_TEMP_TO_COUNTS( 25 + LM35_MAX_TEMP_CHANGE ) -
+                INTERNAL_TEMP_TO_COUNTS( 25 ) ),
+};
+
+static const analogSensorLimits_t tmp117Limits = {
+    TMP117_TEMP_TO_COUNTS( TMP117_MIN_PLAUSIBLE_TEMP ),
+    TMP117_TEMP_TO_COUNTS( TMP117_MAX_PLAUSIBLE_TEMP ),
+    0,
+    TMP117_TEMP_TO_COUNTS( LM35_MAX_TEMP_CHANGE ) - TMP117_TEMP_TO_COUNTS( 0 ),
+};
+
+static temperatureSensor_t temperatureSensors[TEMPERATURE_VOTER_MAX_CHANNELS];
+static int numberOfTemperatureSensors = 0;
+
+static const samplingMode_t samplingModes[] = {
+    { 200, 10, 0.0, 0.0 },                      // 2 s window
+    { 50, 20, 10.0, 1.0 },                      // 1 s window
+    { TIME_INCREMENT_MS, 25, 3.0, 3.0 },        // 250 ms window
+};
+static const int numberOfSamplingModes = sizeof( samplingModes ) /
+                                         sizeof( samplingModes[0] );
+static timerWheelTimer_t temperatureSamplingTimer;
+static int samplingMode = 0;
+static uint32_t samplingModeNeededTicks = 0;
+
+// @note Fed with every LM35 sample, in hundredths of a degree; it also gives
+// the rate of change used to choose the sampling mode.
+static kalmanFilter_t lm35KalmanFilter;
+static timerWheelTimer_t tmp117SamplingTimer;
+
+static timerWheelTimer_t sensorCheckTimer;
+static int mq2Transitions = 0;
+
+static timerWheelTimer_t mqttReadingTimer;
+
+static timerWheelTimer_t historySamplingTimer;
+static timerWheelTimer_t lcdRefreshTimer;
+static uint64_t historyEncodeCycles = 0;
+static uint32_t historyEncodedSamples = 0;
+
+static uint16_t statusSnapshotSequence = 0;
+
+// @note Inputs and state of the functions timed by the benchmark mode, only
+// built into the benchmark build, like the rest of the benchmark code.
+#if BENCHMARK
+static float benchmarkSamples[NUMBER_OF_AVG_SAMPLES];
+static movingAverage_t benchmarkFilter;
+static kalmanFilter_t benchmarkKalman;
+static volatile float benchmarkSink;
+#endif
+
+// @note State of the multi-step UART dialog in progress, if any. A suspended
+// dialog keeps only these few bytes alive between calls of uartTask().
+static protothread_t uartDialogThread;
+static protothreadFunction_t uartDialog = NULL;
+static char uartDialogChar = '\0';
+
+// @note Received characters are stored by the RX interrupt, so a burst of
+// commands is not lost between two calls of uartTask().
+static SpscQueue<char, UART_RX_BUFFER_SIZE> uartRxQueue;
+
+// @note Rates above 921600 baud depend on the USB-serial adapter of the host;
+// the ST-LINK virtual COM port handles them.
+static const int uartBaudRates[] = { 9600, 115200, 230400, 460800, 921600,
+                                     1843200 };
+static const int uartNumberOfBaudRates = sizeof( uartBaudRates ) /
+                                         sizeof( uartBaudRates[0] );
+static int uartBaudRate = UART_BAUD_RATE;
+static bool uartAutoBaudPending = MBED_CONF_APP_CONSOLE_AUTO_BAUD;
+
+// Responses of one tick, sent with a single write by consoleFlush().
+static char uartTxBuffer[UART_TX_BUFFER_SIZE];
+static int uartTxLength = 0;
 
 //=====[Declarations (prototypes) of public functions]=========================
 
@@ -99,21 +406,165 @@ void alarmDeactivationUpdate();
 
 void uartTask();
 void availableCommands();
-bool areEqual();
+void memoryUsageReport();
+bool codeMatches( const char * code );
+bool codeKeyIsValid( char key );
 float celsiusToFahrenheit( float tempInCelsiusDegrees );
 float analogReadingScaledWithTheLM35Formula( float analogReading );
+float analogReadingScaledWithTheInternalSensorFormula( float analogReading );
+float analogReadingScaledWithTheTmp117Formula( float analogReading );
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static void alarmBlinkingTimeSet( int blinkingTimeMs );
+static void alarmLedToggle( void * context );
+
+static void potentiometerThresholdTuningSet( bool enabled );
+static void potentiometerThresholdUpdate( void * context );
+
+static void temperatureSensorsInit();
+static void temperatureSensorAdd( int sensorType, const char * name,
+                                  uint16_t (*rawRead)(), bool (*isPresent)(),
+                                  float (*formula)( float analogReading ),
+                                  const analogSensorLimits_t * limits );
+static uint16_t lm35RawRead();
+static uint16_t lm35RedundantRawRead();
+static uint16_t internalTempSensorRawRead();
+static uint16_t tmp117CountsRead();
+static bool tmp117SensorIsPresent();
+static int mq2Read();
+static bool keypadEventRead( matrixKeypadEvent_t * event );
+static void tmp117SamplingUpdate( void * context );
+static void temperatureSensorsUpdate();
+static bool temperatureSensorReadsHigh( const temperatureSensor_t * sensor );
+static void temperatureSamplingUpdate( void * context );
+static void samplingModeUpdate();
+static void samplingModeSet( int mode );
+static void sensorFaultsUpdate( void * context );
+static void sensorFaultReport( const char * sensorName, uint8_t faults,
+                               uint8_t * reportedFaults );
+
+static void statusReportFill( statusReport_t * report );
+static void sharedStateUpdate();
+static void statusSnapshotSend( bool binary );
+static void alarmEventsPublish();
+static void mqttReadingPublish( void * context );
+static void historySamplingUpdate( void * context );
+static void lcdRefresh( void * context );
+#if BENCHMARK
+static void benchmarksRun();
+static void benchmarkLm35Formula( void * context );
+static void benchmarkFloatAverage( void * context );
+static void benchmarkMovingAverage( void * context );
+static void benchmarkKalmanFilter( void * context );
+static void benchmarkSprintfFloat( void * context );
+static void benchmarkStatusReport( void * context );
+static void benchmarkAlarmActivation( void * context );
+static void benchmarkAlarmDeactivation( void * context );
+static void alarmStateSave( alarmStateSnapshot_t * snapshot );
+static void alarmStateRestore( const alarmStateSnapshot_t * snapshot );
+#endif
+static void historySampleWrite( uint32_t timeMs, int32_t value, void * context );
+static void rollupBucketWrite( const rollupBucket_t * bucket, bool closed,
+                               void * context );
+
+static void uartRxInterrupt();
+static void uartCommandExecute( char receivedChar );
+static void consoleWrite( const char * buffer, int length );
+static void consoleFlush();
+static void uartAutoBaudUpdate();
+static bool uartBaudRateConfirmed();
+static void uartDialogStart( protothreadFunction_t dialog );
+static bool uartDialogCharRead();
+static protothreadStatus_t codeEntryDialog( protothread_t * pt );
+static protothreadStatus_t newCodeDialog( protothread_t * pt );
+static protothreadStatus_t baudRateDialog( protothread_t * pt );
+static protothreadStatus_t throughputTestDialog( protothread_t * pt );
+static protothreadStatus_t historyReportDialog( protothread_t * pt );
+static protothreadStatus_t rollupReportDialog( protothread_t * pt );
+static protothreadStatus_t traceDumpDialog( protothread_t * pt );
 
 //=====[Main function, the program entry point after power on or reset]========
 
 int main()
 {
+    cycleCounterInit();
+    tickClockInit( VIRTUAL_CLOCK ? &tickClockVirtual : &tickClockReal,
+                   TIME_INCREMENT_MS );
+    if ( SIMULATED_INPUTS_SEED ) {
+        simulatedInputsInit( SIMULATED_INPUTS_SEED, codeSequence,
+                             NUMBER_OF_KEYS );
+    }
+    traceInit();
     inputsInit();
     outputsInit();
+    timerWheelInit();
+#if MBED_CONF_APP_I2C_SIMULATED_BUS
+    i2cSchedulerInit( &i2cSimulatedBus );
+#else
+    i2cSchedulerInit( &i2cMbedBus );
+#endif
+    temperatureSensorsInit();
+    potentiometerThresholdTuningSet( MBED_CONF_APP_POTENTIOMETER_THRESHOLD_TUNING );
+    timerWheelStart( &sensorCheckTimer, SENSOR_CHECK_TIME, SENSOR_CHECK_TIME,
+                     sensorFaultsUpdate, NULL );
+    sharedStateUpdate();
+    networkInit();
+    udpEndpointInit( sharedStateRead );
+    mqttPublisherInit();
+    timerWheelStart( &mqttReadingTimer, MQTT_READING_PERIOD,
+                     MQTT_READING_PERIOD, mqttReadingPublish, NULL );
+    sampleHistoryInit( HISTORY_SAMPLING_TIME );
+    rollupInit();
+    timerWheelStart( &historySamplingTimer, HISTORY_SAMPLING_TIME,
+                     HISTORY_SAMPLING_TIME, historySamplingUpdate, NULL );
+    if ( MBED_CONF_APP_LCD_ENABLED ) {
+        characterLcdInit();
+        timerWheelStart( &lcdRefreshTimer, LCD_REFRESH_TIME, LCD_REFRESH_TIME,
+                         lcdRefresh, NULL );
+    }
+#if BENCHMARK
+    benchmarksRun();
+#endif
+    heapGuardArm();
     while (true) {
+        if ( SIMULATED_INPUTS_SEED ) {
+            simulatedInputsUpdate( timerWheelTicks() * TIME_INCREMENT_MS,
+                                   alarmState );
+            if ( MBED_CONF_APP_I2C_SIMULATED_BUS ) {
+                i2cSimulatedBusTemperatureSet(
+                    simulatedInputsTemperatureRead() );
+            }
+        }
+        traceBegin( TRACE_EVENT_ALARM_ACTIVATION );
         alarmActivationUpdate();
+        traceEnd( TRACE_EVENT_ALARM_ACTIVATION );
+        traceBegin( TRACE_EVENT_ALARM_DEACTIVATION );
         alarmDeactivationUpdate();
+        traceEnd( TRACE_EVENT_ALARM_DEACTIVATION );
+        alarmEventsPublish();
+        traceBegin( TRACE_EVENT_UART_TASK );
         uartTask();
-        delay(TIME_INCREMENT_MS);
+        traceEnd( TRACE_EVENT_UART_TASK );
+        traceBegin( TRACE_EVENT_NETWORK );
+        networkUpdate();
+        udpEndpointUpdate();
+        mqttPublisherUpdate();
+        traceEnd( TRACE_EVENT_NETWORK );
+        traceBegin( TRACE_EVENT_IDLE );
+        tickClockWait();
+        traceEnd( TRACE_EVENT_IDLE );
+        if ( MBED_CONF_APP_I2C_SIMULATED_BUS ) {
+            i2cSimulatedBusUpdate();
+        }
+        i2cSchedulerUpdate();
+        if ( MBED_CONF_APP_LCD_ENABLED ) {
+            characterLcdUpdate();
+        }
+        traceBegin( TRACE_EVENT_TIMER_WHEEL );
+        timerWheelUpdate();
+        traceEnd( TRACE_EVENT_TIMER_WHEEL );
+        sharedStateUpdate();
     }
 }
 
@@ -122,12 +573,10 @@ int main()
 void inputsInit()
 {
     alarmTestButton.mode(PullDown);
-    aButton.mode(PullDown);
-    bButton.mode(PullDown);
-    cButton.mode(PullDown);
-    dButton.mode(PullDown);
     sirenPin.mode(OpenDrain);
     sirenPin.input();
+    uartUsb.attach( uartRxInterrupt, SerialBase::RxIrq );
+    matrixKeypadInit();
 }
 
 void outputsInit()
@@ -139,29 +588,30 @@ void outputsInit()
 
 void alarmActivationUpdate()
 {
-    static int lm35SampleIndex = 0;
-    int i = 0;
+    static int previousMq2Reading = ON;
+    int mq2Reading;
 
-    lm35ReadingsArray[lm35SampleIndex] = lm35.read(); // @note Reads the input voltage using function analogin_read() (declared in /home/studio/workspace/example-3.5-tp_03/mbed-os/hal/include/hal/analogin_api.h)
-    lm35SampleIndex++;
-    if ( lm35SampleIndex >= NUMBER_OF_AVG_SAMPLES) {
-        lm35SampleIndex = 0;
-    }
-    
-       lm35ReadingsSum = 0.0;
-    for (i = 0; i < NUMBER_OF_AVG_SAMPLES; i++) {
-        lm35ReadingsSum = lm35ReadingsSum + lm35ReadingsArray[i];
-    }
-    lm35ReadingsAverage = lm35ReadingsSum / NUMBER_OF_AVG_SAMPLES;
-       lm35TempC = analogReadingScaledWithTheLM35Formula ( lm35ReadingsAverage );    
-    
-    if ( lm35TempC > OVER_TEMP_LEVEL ) {
+    // @note A faulty sensor raises a fault, never the alarm: the vote only
+    // counts the sensors without faults. With none left, the fault is
+    // reported, and the alarm is only raised as well with
+    // TEMPERATURE_FAIL_SAFE.
+    if ( temperatureVoteResult.overTemp ||
+         ( TEMPERATURE_FAIL_SAFE &&
+           ( temperatureFaults & SENSOR_FAULT_NO_VALID_SENSOR ) ) ) {
         overTempDetector = ON;
     } else {
         overTempDetector = OFF;
     }
 
-    if( !mq2) {
+    // @note Read once, so the transition count and the gas check see the
+    // same value.
+    mq2Reading = mq2Read();
+    if ( mq2Reading != previousMq2Reading ) {
+        previousMq2Reading = mq2Reading;
+        mq2Transitions++;
+    }
+
+    if( !mq2Reading && mq2Faults == SENSOR_FAULT_NONE ) {
         gasDetectorState = ON;
         alarmState = ON;
     }
@@ -175,27 +625,18 @@ void alarmActivationUpdate()
         alarmState = ON;
     }    
     if( alarmState ) { 
-        accumulatedTimeAlarm = accumulatedTimeAlarm + TIME_INCREMENT_MS;
         sirenPin.output();                                     
         sirenPin = LOW;                                        
     
         if( gasDetectorState && overTempDetectorState ) {
-            if( accumulatedTimeAlarm >= BLINKING_TIME_GAS_AND_OVER_TEMP_ALARM ) {
-                accumulatedTimeAlarm = 0;
-                alarmLed = !alarmLed;
-            }
+            alarmBlinkingTimeSet( BLINKING_TIME_GAS_AND_OVER_TEMP_ALARM );
         } else if( gasDetectorState ) {
-            if( accumulatedTimeAlarm >= BLINKING_TIME_GAS_ALARM ) {
-                accumulatedTimeAlarm = 0;
-                alarmLed = !alarmLed;
-            }
+            alarmBlinkingTimeSet( BLINKING_TIME_GAS_ALARM );
         } else if ( overTempDetectorState ) {
-            if( accumulatedTimeAlarm >= BLINKING_TIME_OVER_TEMP_ALARM  ) {
-                accumulatedTimeAlarm = 0;
-                alarmLed = !alarmLed;
-            }
+            alarmBlinkingTimeSet( BLINKING_TIME_OVER_TEMP_ALARM );
         }
     } else{
+        timerWheelStop( &alarmBlinkTimer );
         alarmLed = OFF;
         gasDetectorState = OFF;
         overTempDetectorState = OFF;
@@ -203,199 +644,1448 @@ void alarmActivationUpdate()
     }
 }
 
+// @note The code is typed on the keypad and submitted with '#'; '*' clears
+// the keys typed so far and the incorrect code LED. Only presses count, and
+// keys past NUMBER_OF_KEYS make the code incorrect.
 void alarmDeactivationUpdate()
 {
-    if ( numberOfIncorrectCodes < 5 ) {
-        if ( aButton && bButton && cButton && dButton && !enterButton ) {
-            incorrectCodeLed = OFF;
+    matrixKeypadEvent_t event;
+
+    while ( keypadEventRead( &event ) ) {
+        if ( !event.pressed || numberOfIncorrectCodes >= 5 ) {
+            continue;
         }
-        if ( enterButton && !incorrectCodeLed && alarmState ) {
-            buttonsPressed[0] = aButton;
-            buttonsPressed[1] = bButton;
-            buttonsPressed[2] = cButton;
-            buttonsPressed[3] = dButton;
-            if ( areEqual() ) {
-                alarmState = OFF;
-                numberOfIncorrectCodes = 0;
-            } else {
-                incorrectCodeLed = ON;
-                numberOfIncorrectCodes++;
+        if ( event.key == '*' ) {
+            numberOfKeysPressed = 0;
+            incorrectCodeLed = OFF;
+        } else if ( event.key == '#' ) {
+            if ( !incorrectCodeLed && alarmState ) {
+                if ( numberOfKeysPressed == NUMBER_OF_KEYS &&
+                     codeMatches( keysPressed ) ) {
+                    alarmState = OFF;
+                    numberOfIncorrectCodes = 0;
+                } else {
+                    incorrectCodeLed = ON;
+                    numberOfIncorrectCodes++;
+                }
             }
+            numberOfKeysPressed = 0;
+        } else if ( numberOfKeysPressed < NUMBER_OF_KEYS ) {
+            keysPressed[numberOfKeysPressed] = event.key;
+            numberOfKeysPressed++;
+        } else {
+            numberOfKeysPressed = NUMBER_OF_KEYS + 1;
         }
-    } else {
+    }
+
+    if ( numberOfIncorrectCodes >= 5 ) {
         systemBlockedLed = ON;
     }
 }
 
+// @note Executes every command received since the previous call, up to
+// UART_COMMANDS_PER_TICK, and sends all the answers in one burst. A dialog in
+// progress gets the characters first, as before.
 void uartTask()
 {
-    printf("UART Task initiated.");
     char receivedChar = '\0';
-    char str[100];
-    int stringLength;
-    if( uartUsb.readable() ) {
-        uartUsb.read( &receivedChar, 1 );
-        switch (receivedChar) {
-        case '1':
-            if ( alarmState ) {
-                uartUsb.write( "The alarm is activated\r\n", 24);
-            } else {
-                uartUsb.write( "The alarm is not activated\r\n", 28);
-            }
-            break;
+    int commands;
 
-        case '2':
-            if ( !mq2 ) {
-                uartUsb.write( "Gas is being detected\r\n", 22);
-            } else {
-                uartUsb.write( "Gas is not being detected\r\n", 27);
-            }
-            break;
+    if ( uartAutoBaudPending ) {
+        uartAutoBaudUpdate();
+        consoleFlush();
+        return;
+    }
 
-        case '3':
-            if ( overTempDetector ) {
-                uartUsb.write( "Temperature is above the maximum level\r\n", 40);
-            } else {
-                uartUsb.write( "Temperature is below the maximum level\r\n", 40);
+    for ( commands = 0; commands < UART_COMMANDS_PER_TICK; commands++ ) {
+        if ( uartDialog != NULL ) {
+            if ( uartDialog( &uartDialogThread ) == PT_ENDED ) {
+                uartDialog = NULL;
+            } else if ( uartRxQueue.empty() ) {
+                break;
             }
-            break;
-            
-        case '4':
-            uartUsb.write( "Please enter the code sequence.\r\n", 33 );
-            uartUsb.write( "First enter 'A', then 'B', then 'C', and ", 41 ); 
-            uartUsb.write( "finally 'D' button\r\n", 20 );
-            uartUsb.write( "In each case type 1 for pressed or 0 for ", 41 );
-            uartUsb.write( "not pressed\r\n", 13 );
-            uartUsb.write( "For example, for 'A' = pressed, ", 32 );
-            uartUsb.write( "'B' = pressed, 'C' = not pressed, ", 34);
-            uartUsb.write( "'D' = not pressed, enter '1', then '1', ", 40 );
-            uartUsb.write( "then '0', and finally '0'\r\n\r\n", 29 );
-
-            incorrectCode = false;
-
-            for ( buttonBeingCompared = 0;
-                  buttonBeingCompared < NUMBER_OF_KEYS;
-                  buttonBeingCompared++) {
-
-                uartUsb.read( &receivedChar, 1 );
-                uartUsb.write( "*", 1 );
-
-                if ( receivedChar == '1' ) {
-                    if ( codeSequence[buttonBeingCompared] != 1 ) {
-                        incorrectCode = true;
-                    }
-                } else if ( receivedChar == '0' ) {
-                    if ( codeSequence[buttonBeingCompared] != 0 ) {
-                        incorrectCode = true;
-                    }
-                } else {
-                    incorrectCode = true;
-                }
+        } else if ( uartRxQueue.pop( receivedChar ) ) {
+            uartCommandExecute( receivedChar );
+            if ( uartDialog != NULL ) {
+                // A dialog runs its first step at once: the next one waits
+                // for the next tick, so a report sends one buffer per call.
+                break;
             }
-
-            if ( incorrectCode == false ) {
-                uartUsb.write( "\r\nThe code is correct\r\n\r\n", 25 );
-                alarmState = OFF;
-                incorrectCodeLed = OFF;
-                numberOfIncorrectCodes = 0;
-            } else {
-                uartUsb.write( "\r\nThe code is incorrect\r\n\r\n", 27 );
-                incorrectCodeLed = ON;
-                numberOfIncorrectCodes++;
-            }                
+        } else {
             break;
+        }
+    }
+    consoleFlush();
+}
 
-        case '5':
-            uartUsb.write( "Please enter new code sequence\r\n", 32 );
-            uartUsb.write( "First enter 'A', then 'B', then 'C', and ", 41 );
-            uartUsb.write( "finally 'D' button\r\n", 20 );
-            uartUsb.write( "In each case type 1 for pressed or 0 for not ", 45 );
-            uartUsb.write( "pressed\r\n", 9 );
-            uartUsb.write( "For example, for 'A' = pressed, 'B' = pressed,", 46 );
-            uartUsb.write( " 'C' = not pressed,", 19 );
-            uartUsb.write( "'D' = not pressed, enter '1', then '1', ", 40 );
-            uartUsb.write( "then '0', and finally '0'\r\n\r\n", 29 );
-
-            for ( buttonBeingCompared = 0; 
-                  buttonBeingCompared < NUMBER_OF_KEYS; 
-                  buttonBeingCompared++) {
-
-                uartUsb.read( &receivedChar, 1 );
-                uartUsb.write( "*", 1 );
-
-                if ( receivedChar == '1' ) {
-                    codeSequence[buttonBeingCompared] = 1;
-                } else if ( receivedChar == '0' ) {
-                    codeSequence[buttonBeingCompared] = 0;
-                }
-            }
+void availableCommands()
+{
+    consoleWrite( "Available commands:\r\n", 21 );
+    consoleWrite( "Press '1' to get the alarm state\r\n", 34 );
+    consoleWrite( "Press '2' to get the gas detector state\r\n", 41 );
+    consoleWrite( "Press '3' to get the over temperature detector state\r\n", 54 );
+    consoleWrite( "Press '4' to enter the code sequence\r\n", 38 );
+    consoleWrite( "Press '5' to enter a new code\r\n", 31 );
+    consoleWrite( "Press 'P' or 'p' to get potentiometer reading\r\n", 47 );
+    consoleWrite( "Press 'f' or 'F' to get lm35 reading in Fahrenheit\r\n", 52 );
+    consoleWrite( "Press 'c' or 'C' to get lm35 reading in Celsius\r\n", 49 );
+    consoleWrite( "Press 't' or 'T' to toggle the potentiometer threshold tuning\r\n", 63 );
+    consoleWrite( "Press 'm' or 'M' to get the memory usage\r\n", 42 );
+    consoleWrite( "Press 's' or 'S' to get the whole state as text or binary\r\n", 59 );
+    consoleWrite( "Press 'h' or 'H' to get the temperature history\r\n", 49 );
+    consoleWrite( "Press 'r' or 'R' to get the temperature statistics\r\n", 52 );
+    consoleWrite( "Press 'b' or 'B' to change the baud rate\r\n", 42 );
+    consoleWrite( "Press 'x' or 'X' to measure the transmit throughput\r\n", 53 );
+    consoleWrite( "Press 'e' or 'E' to dump the event trace\r\n\r\n", 44 );
+}
+
+// @note The stack high-water marks come from the RTX stack watermarking
+// (each thread stack is painted at creation and the untouched part is
+// measured), enabled by "platform.stack-stats-enabled" in mbed_app.json.
+void memoryUsageReport()
+{
+    mbed_stats_thread_t threadStats[MEMORY_REPORT_MAX_THREADS];
+    mbed_stats_heap_t heapStats;
+    mqttPublisherStats_t mqttStats;
+    char str[100];
+    int numberOfThreads;
+    int i;
+
+    numberOfThreads = mbed_stats_thread_get_each( threadStats,
+                                                  MEMORY_REPORT_MAX_THREADS );
+    for ( i = 0; i < numberOfThreads; i++ ) {
+        sprintf( str, "Stack %s: %lu of %lu bytes used\r\n",
+                 threadStats[i].name ? threadStats[i].name : "?",
+                 (unsigned long)( threadStats[i].stack_size -
+                                  threadStats[i].stack_space ),
+                 (unsigned long)threadStats[i].stack_size );
+        consoleWrite( str, strlen( str ) );
+    }
+
+    mbed_stats_heap_get( &heapStats );
+    sprintf( str, "Heap: %lu bytes in use, %lu bytes peak, %lu bytes free\r\n",
+             (unsigned long)heapStats.current_size,
+             (unsigned long)heapStats.max_size,
+             (unsigned long)( heapStats.reserved_size - heapStats.current_size ) );
+    consoleWrite( str, strlen( str ) );
+
+    sprintf( str, "Heap allocations after initialization: %lu (last from %p)\r\n",
+             (unsigned long)heapGuardViolations(), heapGuardLastCaller() );
+    consoleWrite( str, strlen( str ) );
+
+    sprintf( str, "Control loop: %lu ticks, %lu late, %lu skipped, "
+             "%s clock\r\n",
+             (unsigned long)timerWheelTicks(),
+             (unsigned long)tickClockOverruns(),
+             (unsigned long)tickClockSkippedTicks(),
+             VIRTUAL_CLOCK ? "virtual" : "real" );
+    consoleWrite( str, strlen( str ) );
+    if ( MBED_CONF_APP_UDP_ENABLED ) {
+        sprintf( str, "UDP endpoint: port %d %s, socket error %d\r\n",
+                 MBED_CONF_APP_UDP_PORT,
+                 udpEndpointIsConnected() ? "open" : "closed",
+                 udpEndpointError() );
+        consoleWrite( str, strlen( str ) );
+    }
+    if ( MBED_CONF_APP_MQTT_ENABLED ) {
+        mqttPublisherStatsGet( &mqttStats );
+        sprintf( str, "MQTT: %s, %lu published, %lu acknowledged, "
+                 "%lu retransmitted, %d queued\r\n",
+                 mqttPublisherIsConnected() ? "connected" : "disconnected",
+                 (unsigned long)mqttStats.published,
+                 (unsigned long)mqttStats.acknowledged,
+                 (unsigned long)mqttStats.retransmitted, mqttStats.queued );
+        consoleWrite( str, strlen( str ) );
+        sprintf( str, "MQTT: %lu dropped, %lu of them alarm events, "
+                 "socket error %d\r\n",
+                 (unsigned long)mqttStats.dropped,
+                 (unsigned long)mqttStats.alarmEventsDropped,
+                 mqttStats.socketError );
+        consoleWrite( str, strlen( str ) );
+    }
+    if ( SIMULATED_INPUTS_SEED ) {
+        sprintf( str, "Simulated inputs: seed %lu, %.2f \xB0 C\r\n",
+                 (unsigned long)simulatedInputsSeed(),
+                 simulatedInputsTemperatureGet() );
+        consoleWrite( str, strlen( str ) );
+    }
+}
+
+// @note Compares every key whatever the result, so the time taken does not
+// tell how many leading keys were right.
+bool codeMatches( const char * code )
+{
+    int i;
+    char difference = 0;
+
+    for (i = 0; i < NUMBER_OF_KEYS; i++) {
+        difference |= codeSequence[i] ^ code[i];
+    }
+
+    return difference == 0;
+}
+
+bool codeKeyIsValid( char key )
+{
+    return ( key >= '0' && key <= '9' ) || ( key >= 'A' && key <= 'D' );
+}
+
+float analogReadingScaledWithTheLM35Formula( float analogReading )
+{
+    return ( analogReading * 3.3 / 0.01 );
+}
+
+float analogReadingScaledWithTheInternalSensorFormula( float analogReading )
+{
+    return ( ( analogReading * 3.3 - 0.76 ) / 0.0025 + 25.0 );
+}
+
+float analogReadingScaledWithTheTmp117Formula( float analogReading )
+{
+    return ( ( analogReading * MOVING_AVERAGE_FULL_SCALE - 32768 ) *
+             TMP117_RESOLUTION_C );
+}
+
+float celsiusToFahrenheit( float tempInCelsiusDegrees )
+{
+    return ( tempInCelsiusDegrees * 9.0 / 5.0 + 32.0 );
+}
 
-            uartUsb.write( "\r\nNew code generated\r\n\r\n", 24 );
+//=====[Implementations of private functions]==================================
+
+// @note The blinking is driven by a periodic timer of the timer wheel, which
+// is only restarted when the kind of alarm (and therefore the period) changes.
+static void alarmBlinkingTimeSet( int blinkingTimeMs )
+{
+    if ( !timerWheelIsRunning( &alarmBlinkTimer ) ||
+         timerWheelPeriodMs( &alarmBlinkTimer ) != blinkingTimeMs ) {
+        timerWheelStart( &alarmBlinkTimer, blinkingTimeMs, blinkingTimeMs,
+                         alarmLedToggle, NULL );
+    }
+}
+
+static void alarmLedToggle( void * context )
+{
+    alarmLed = !alarmLed;
+}
+
+// @note While enabled, the potentiometer sets overTempLevel between
+// OVER_TEMP_LEVEL_MIN and OVER_TEMP_LEVEL_MAX in steps of 1 degree. When it
+// is disabled the last tuned level is kept.
+static void potentiometerThresholdTuningSet( bool enabled )
+{
+    potentiometerThresholdTuning = enabled;
+    if ( enabled ) {
+        potentiometerFilterState = (uint32_t)potentiometer.read_u16()
+                                   << POTENTIOMETER_FILTER_SHIFT;
+        timerWheelStart( &potentiometerSamplingTimer,
+                         POTENTIOMETER_SAMPLING_TIME,
+                         POTENTIOMETER_SAMPLING_TIME,
+                         potentiometerThresholdUpdate, NULL );
+    } else {
+        timerWheelStop( &potentiometerSamplingTimer );
+    }
+}
+
+// @note The level only moves when the filtered position is more than one
+// step away from the current level, so noise or a knob resting on the edge
+// of a step does not make the threshold toggle.
+static void potentiometerThresholdUpdate( void * context )
+{
+    char str[40];
+    int positionTenths;
+
+    potentiometerFilterState = potentiometerFilterState
+                             - ( potentiometerFilterState >> POTENTIOMETER_FILTER_SHIFT )
+                             + potentiometer.read_u16();
+
+    positionTenths = OVER_TEMP_LEVEL_MIN * 10 +
+                     (int)( ( potentiometerFilterState >> POTENTIOMETER_FILTER_SHIFT ) *
+                            ( OVER_TEMP_LEVEL_MAX - OVER_TEMP_LEVEL_MIN ) * 10 /
+                            MOVING_AVERAGE_FULL_SCALE );
+
+    if ( positionTenths > overTempLevel * 10 + 10 ||
+         positionTenths < overTempLevel * 10 - 10 ) {
+        overTempLevel = ( positionTenths + 5 ) / 10;
+        sprintf( str, "Over temperature level: %d \xB0 C\r\n", overTempLevel );
+        consoleWrite( str, strlen( str ) );
+    }
+}
+
+static void temperatureSensorsInit()
+{
+    numberOfTemperatureSensors = 0;
+    temperatureSensorAdd( TEMPERATURE_SENSOR_LM35, "LM35",
+                          lm35RawRead, NULL,
+                          analogReadingScaledWithTheLM35Formula, &lm35Limits );
+    temperatureSensorAdd( TEMPERATURE_SENSOR_LM35_REDUNDANT, "Redundant LM35",
+                          lm35RedundantRawRead, NULL,
+                          analogReadingScaledWithTheLM35Formula, &lm35Limits );
+    temperatureSensorAdd( TEMPERATURE_SENSOR_INTERNAL, "MCU temperature sensor",
+                          internalTempSensorRawRead, NULL,
+                          analogReadingScaledWithTheInternalSensorFormula,
+                          &internalTempLimits );
+    temperatureSensorAdd( TEMPERATURE_SENSOR_TMP117, "TMP117",
+                          tmp117CountsRead, tmp117SensorIsPresent,
+                          analogReadingScaledWithTheTmp117Formula,
+                          &tmp117Limits );
+
+    if ( ( TEMPERATURE_SENSORS & TEMPERATURE_SENSOR_TMP117 ) &&
+         !TMP117_SIMULATED ) {
+        tmp117Init();
+        timerWheelStart( &tmp117SamplingTimer, TMP117_SAMPLING_TIME,
+                         TMP117_SAMPLING_TIME, tmp117SamplingUpdate, NULL );
+    }
+
+    kalmanFilterInit( &lm35KalmanFilter, KALMAN_PROCESS_NOISE,
+                      KALMAN_MEASUREMENT_NOISE, TIME_INCREMENT_MS );
+    if ( ADAPTIVE_SAMPLING ) {
+        samplingModeSet( numberOfSamplingModes - 1 );
+    } else {
+        timerWheelStart( &temperatureSamplingTimer, TIME_INCREMENT_MS,
+                         TIME_INCREMENT_MS, temperatureSamplingUpdate, NULL );
+    }
+}
+
+static void temperatureSensorAdd( int sensorType, const char * name,
+                                  uint16_t (*rawRead)(), bool (*isPresent)(),
+                                  float (*formula)( float analogReading ),
+                                  const analogSensorLimits_t * limits )
+{
+    temperatureSensor_t * sensor;
+
+    if ( !( TEMPERATURE_SENSORS & sensorType ) ) {
+        return;
+    }
+    sensor = &temperatureSensors[numberOfTemperatureSensors];
+    numberOfTemperatureSensors++;
+
+    sensor->name = name;
+    sensor->rawRead = rawRead;
+    sensor->isPresent = isPresent;
+    sensor->formula = formula;
+    sensor->limits = limits;
+    sensor->faults = SENSOR_FAULT_NONE;
+    sensor->reportedFaults = SENSOR_FAULT_NONE;
+    sensor->previousAverageValid = false;
+    sensor->stuckChecks = 0;
+    sensor->filterSeeded = false;
+    movingAverageInit( &sensor->readingsFilter, NUMBER_OF_AVG_SAMPLES );
+}
+
+static void temperatureSensorsUpdate()
+{
+    temperatureChannel_t channels[TEMPERATURE_VOTER_MAX_CHANNELS];
+    temperatureSensor_t * sensor;
+    uint8_t faults = SENSOR_FAULT_NONE;
+    int i;
+
+    // @note A filter is seeded with the first reading of its sensor, so no
+    // channel votes with the zero-filled window of a fresh filter. A sensor
+    // that is not present is left out, and seeded again when it returns.
+    for ( i = 0; i < numberOfTemperatureSensors; i++ ) {
+        sensor = &temperatureSensors[i];
+        if ( sensor->isPresent != NULL && !sensor->isPresent() ) {
+            sensor->filterSeeded = false;
+        } else if ( !sensor->filterSeeded ) {
+            movingAverageFill( &sensor->readingsFilter, sensor->rawRead() );
+            sensor->filterSeeded = true;
+        } else {
+            movingAverageUpdate( &sensor->readingsFilter, sensor->rawRead() );
+        }
+        sensor->faults = ( sensor->faults & ~( SENSOR_FAULT_OUT_OF_RANGE |
+                                               SENSOR_FAULT_OPEN ) ) |
+                         analogSensorRangeCheck( &sensor->readingsFilter,
+                                                 sensor->limits );
+        if ( !sensor->filterSeeded ) {
+            sensor->faults |= SENSOR_FAULT_OPEN;
+        }
+        channels[i].temperature = sensor->formula(
+            movingAverageReadNormalized( &sensor->readingsFilter ) );
+        channels[i].valid = ( sensor->faults == SENSOR_FAULT_NONE ) ||
+                            temperatureSensorReadsHigh( sensor );
+        faults |= sensor->faults;
+    }
+
+    // @note The LM35 is always the first sensor. With KALMAN_FILTER its vote
+    // uses the Kalman estimate, which lags less than the moving average; the
+    // fault checks keep using the moving average.
+    lm35ReadingsAverage = movingAverageReadNormalized(
+        &temperatureSensors[0].readingsFilter );
+    kalmanFilterUpdate( &lm35KalmanFilter, (int32_t)( 100 *
+        analogReadingScaledWithTheLM35Formula(
+            movingAverageLastSample( &temperatureSensors[0].readingsFilter ) /
+            (float)MOVING_AVERAGE_FULL_SCALE ) ) );
+    lm35TempRateCPerS = kalmanFilterRate( &lm35KalmanFilter ) / 100.0;
+    if ( KALMAN_FILTER && temperatureSensors[0].faults == SENSOR_FAULT_NONE ) {
+        channels[0].temperature = kalmanFilterValue( &lm35KalmanFilter ) / 100.0;
+    }
+    lm35TempC = channels[0].temperature;
+
+    temperatureVote( channels, numberOfTemperatureSensors,
+                     TEMPERATURE_VOTES_REQUIRED,
+                     overTempLevel, TEMPERATURE_TOLERANCE,
+                     &temperatureVoteResult );
+    if ( temperatureVoteResult.disagreement ) {
+        faults |= SENSOR_FAULT_DISAGREEMENT;
+    }
+    if ( temperatureVoteResult.validChannels == 0 ) {
+        faults |= SENSOR_FAULT_NO_VALID_SENSOR;
+    }
+    temperatureFaults = faults;
+}
+
+// @note Fail-safe: a reading above the plausible range is a fault, but it
+// may also be a real fire or a short to the supply, so the sensor keeps
+// voting, for over temperature. Only a sensor known to be absent does not.
+static bool temperatureSensorReadsHigh( const temperatureSensor_t * sensor )
+{
+    if ( !( sensor->faults & SENSOR_FAULT_OUT_OF_RANGE ) ||
+         ( sensor->faults & SENSOR_FAULT_OPEN ) ) {
+        return false;
+    }
+    return movingAverageLastSample( &sensor->readingsFilter ) >
+           sensor->limits->maxCounts ||
+           movingAverageRead( &sensor->readingsFilter ) >
+           sensor->limits->maxCounts;
+}
+
+static void temperatureSamplingUpdate( void * context )
+{
+    traceBegin( TRACE_EVENT_TEMPERATURE_SAMPLING );
+    temperatureSensorsUpdate();
+    rollupAdd( timerWheelTicks() * TIME_INCREMENT_MS, (int32_t)( lm35TempC * 100 ) );
+    if ( ADAPTIVE_SAMPLING ) {
+        samplingModeUpdate();
+    }
+    traceEnd( TRACE_EVENT_TEMPERATURE_SAMPLING );
+}
+
+// @note Speeds up at once, but only slows down after the slower mode has been
+// enough for SAMPLING_SLOWDOWN_TIME, so the rate does not chatter around a
+// margin.
+static void samplingModeUpdate()
+{
+    uint32_t ticks = timerWheelTicks();
+    float distance = overTempLevel - temperatureVoteResult.temperature;
+    int mode;
+
+    for ( mode = numberOfSamplingModes - 1; mode > 0; mode-- ) {
+        if ( distance < samplingModes[mode].marginC ||
+             fabs( lm35TempRateCPerS ) >= samplingModes[mode].slopeCPerS ) {
             break;
+        }
+    }
+
+    if ( mode >= samplingMode ) {
+        samplingModeNeededTicks = ticks;
+        if ( mode > samplingMode ) {
+            samplingModeSet( mode );
+        }
+    } else if ( ticks - samplingModeNeededTicks >=
+                SAMPLING_SLOWDOWN_TIME / TIME_INCREMENT_MS ) {
+        samplingModeSet( mode );
+    }
+}
+
+static void samplingModeSet( int mode )
+{
+    int i;
+
+    samplingMode = mode;
+    samplingModeNeededTicks = timerWheelTicks();
+    for ( i = 0; i < numberOfTemperatureSensors; i++ ) {
+        movingAverageWindowSet( &temperatureSensors[i].readingsFilter,
+                                samplingModes[mode].windowSamples );
+    }
+    kalmanFilterPeriodSet( &lm35KalmanFilter, samplingModes[mode].periodMs );
+    timerWheelStart( &temperatureSamplingTimer, samplingModes[mode].periodMs,
+                     samplingModes[mode].periodMs, temperatureSamplingUpdate,
+                     NULL );
+}
+
+// @note Reads the raw conversion using function analogin_read_u16() (declared
+// in /home/studio/workspace/example-3.5-tp_03/mbed-os/hal/include/hal/analogin_api.h),
+// scaled to 16 bits.
+static uint16_t lm35RawRead()
+{
+    if ( SIMULATED_INPUTS_SEED ) {
+        return LM35_TEMP_TO_COUNTS( simulatedInputsTemperatureRead() );
+    }
+    return lm35.read_u16();
+}
+
+static uint16_t lm35RedundantRawRead()
+{
+    if ( SIMULATED_INPUTS_SEED ) {
+        return LM35_TEMP_TO_COUNTS( simulatedInputsTemperatureRead() );
+    }
+    return lm35Redundant.read_u16();
+}
+
+static uint16_t internalTempSensorRawRead()
+{
+    if ( SIMULATED_INPUTS_SEED ) {
+        return INTERNAL_TEMP_TO_COUNTS( simulatedInputsTemperatureRead() );
+    }
+    return internalTempSensor.read_u16();
+}
+
+// @note On the simulated bus the TMP117 driver reads the scenario through
+// the bus model; on the real bus the scenario replaces the device, so a run
+// does not depend on whether one is fitted.
+static uint16_t tmp117CountsRead()
+{
+    if ( TMP117_SIMULATED ) {
+        return TMP117_TEMP_TO_COUNTS( simulatedInputsTemperatureRead() );
+    }
+    return (uint16_t)( tmp117RawRead() + 32768 );
+}
+
+static bool tmp117SensorIsPresent()
+{
+    return TMP117_SIMULATED || tmp117IsPresent();
+}
+
+// @note The MQ-2 output is active low, as is the simulated one.
+static int mq2Read()
+{
+    if ( SIMULATED_INPUTS_SEED ) {
+        return !simulatedInputsGasDetected();
+    }
+    return mq2;
+}
+
+// @note With simulated inputs the code is typed by the scenario and the
+// keypad is ignored.
+static bool keypadEventRead( matrixKeypadEvent_t * event )
+{
+    if ( SIMULATED_INPUTS_SEED ) {
+        return simulatedInputsKeyRead( event );
+    }
+    return matrixKeypadEventRead( event );
+}
+
+// @note Only queues the I2C read; the TMP117 driver stores the result when
+// the transfer completes, and tmp117CountsRead() returns the latest one.
+static void tmp117SamplingUpdate( void * context )
+{
+    tmp117Update();
+}
+
+// @note Stuck and rate checks of the temperature sensors use the statistics
+// kept by their filters. The MQ-2 module output is digital, so it is checked
+// for an open line (the input follows the internal pull resistors instead of
+// being driven by the module) and for chattering (too many transitions per
+// check period).
+static void sensorFaultsUpdate( void * context )
+{
+    static uint8_t reportedVotingFaults = SENSOR_FAULT_NONE;
+    static uint8_t reportedMq2Faults = SENSOR_FAULT_NONE;
+    temperatureSensor_t * sensor;
+    uint8_t trendFaults;
+    int mq2WithPullUp;
+    int mq2WithPullDown;
+    int i;
+
+    for ( i = 0; i < numberOfTemperatureSensors; i++ ) {
+        sensor = &temperatureSensors[i];
+        trendFaults = analogSensorTrendCheck( &sensor->readingsFilter,
+                                              sensor->limits,
+                                              sensor->previousAverage );
+        if ( !sensor->previousAverageValid ) {
+            trendFaults &= ~SENSOR_FAULT_RATE;
+        }
+        if ( !( trendFaults & SENSOR_FAULT_STUCK ) ) {
+            sensor->stuckChecks = 0;
+        } else if ( sensor->stuckChecks <
+                    SENSOR_STUCK_TIME / SENSOR_CHECK_TIME ) {
+            sensor->stuckChecks++;
+            trendFaults &= ~SENSOR_FAULT_STUCK;
+        }
+        sensor->faults = ( sensor->faults & ( SENSOR_FAULT_OUT_OF_RANGE |
+                                              SENSOR_FAULT_OPEN ) ) |
+                         trendFaults;
+        sensor->previousAverage = movingAverageRead( &sensor->readingsFilter );
+        sensor->previousAverageValid =
+            movingAverageIsFull( &sensor->readingsFilter );
+        sensorFaultReport( sensor->name, sensor->faults,
+                           &sensor->reportedFaults );
+    }
+    sensorFaultReport( "Temperature voting",
+                       temperatureFaults & ( SENSOR_FAULT_DISAGREEMENT |
+                                             SENSOR_FAULT_NO_VALID_SENSOR ),
+                       &reportedVotingFaults );
+
+    if ( SIMULATED_INPUTS_SEED ) {
+        mq2WithPullUp = mq2Read();
+        mq2WithPullDown = mq2WithPullUp;
+    } else {
+        mq2.mode(PullUp);
+        wait_us(10);
+        mq2WithPullUp = mq2;
+        mq2.mode(PullDown);
+        wait_us(10);
+        mq2WithPullDown = mq2;
+        mq2.mode(PullNone);
+    }
+
+    mq2Faults = SENSOR_FAULT_NONE;
+    if ( mq2WithPullUp && !mq2WithPullDown ) {
+        mq2Faults |= SENSOR_FAULT_OPEN;
+    }
+    if ( mq2Transitions > MQ2_MAX_TRANSITIONS ) {
+        mq2Faults |= SENSOR_FAULT_RATE;
+    }
+    mq2Transitions = 0;
+
+    sensorFaultReport( "MQ-2", mq2Faults, &reportedMq2Faults );
+}
+
+static void sensorFaultReport( const char * sensorName, uint8_t faults,
+                               uint8_t * reportedFaults )
+{
+    char str[60];
+
+    if ( faults == *reportedFaults ) {
+        return;
+    }
+    if ( faults != SENSOR_FAULT_NONE ) {
+        sprintf( str, "%s fault: %s\r\n", sensorName,
+                 sensorFaultDescription( faults ) );
+    } else {
+        sprintf( str, "%s fault cleared\r\n", sensorName );
+    }
+    consoleWrite( str, strlen( str ) );
+    *reportedFaults = faults;
+}
+
+static void statusReportFill( statusReport_t * report )
+{
+    mqttPublisherStats_t mqttStats;
+
+    report->sequence = 0;
+    report->uptimeMs = timerWheelTicks() * TIME_INCREMENT_MS;
+    report->flags = 0;
+    if ( alarmState ) {
+        report->flags |= STATUS_FLAG_ALARM;
+    }
+    if ( !mq2Read() ) {
+        report->flags |= STATUS_FLAG_GAS_DETECTED;
+    }
+    if ( overTempDetector ) {
+        report->flags |= STATUS_FLAG_OVER_TEMP_DETECTED;
+    }
+    if ( gasDetectorState ) {
+        report->flags |= STATUS_FLAG_GAS_ALARM;
+    }
+    if ( overTempDetectorState ) {
+        report->flags |= STATUS_FLAG_OVER_TEMP_ALARM;
+    }
+    if ( systemBlockedLed ) {
+        report->flags |= STATUS_FLAG_SYSTEM_BLOCKED;
+    }
+    if ( incorrectCodeLed ) {
+        report->flags |= STATUS_FLAG_INCORRECT_CODE;
+    }
+    if ( potentiometerThresholdTuning ) {
+        report->flags |= STATUS_FLAG_THRESHOLD_TUNING;
+    }
+    report->numberOfIncorrectCodes = numberOfIncorrectCodes;
+    report->temperatureFaults = temperatureFaults;
+    report->gasFaults = mq2Faults;
+    report->lm35TempCentiC = (int16_t)( lm35TempC * 100 );
+    report->votedTempCentiC = (int16_t)( temperatureVoteResult.temperature * 100 );
+    report->potentiometer = potentiometer.read_u16();
+    report->overTempLevel = overTempLevel;
+    mqttPublisherStatsGet( &mqttStats );
+    report->mqttAlarmEventsDropped = mqttStats.alarmEventsDropped > UINT8_MAX ?
+                                     UINT8_MAX : mqttStats.alarmEventsDropped;
+}
+
+// @note Publishes the state once per tick, after every module has updated
+// it. Readers outside the control loop (network endpoints, console, a future
+// sampling thread) only see it through sharedStateRead().
+static void sharedStateUpdate()
+{
+    statusReport_t state;
+
+    statusReportFill( &state );
+    sharedStatePublish( &state );
+}
+
+// @note The whole state in one record and one write, so a host polling many
+// boards needs a single round trip per board. 'S' sends the binary record of
+// statusReportEncode(), 's' the same fields as a text line.
+static void statusSnapshotSend( bool binary )
+{
+    statusReport_t report;
+    char buffer[STATUS_REPORT_TEXT_SIZE];
+    int length;
+
+    sharedStateRead( &report );
+    report.sequence = statusSnapshotSequence++;
+    if ( binary ) {
+        length = statusReportEncode( &report, (uint8_t *)buffer,
+                                     sizeof( buffer ) );
+    } else {
+        length = statusReportFormat( &report, buffer, sizeof( buffer ) );
+    }
+    consoleWrite( buffer, length );
+}
+
+// @note Publishes one event per change of the alarm or of either detector.
+// Events are queued, so changes during a link outage are still delivered.
+static void alarmEventsPublish()
+{
+    static bool previousAlarmState = OFF;
+    static bool previousGasDetectorState = OFF;
+    static bool previousOverTempDetectorState = OFF;
+    char payload[64];
+
+    if ( alarmState == previousAlarmState &&
+         gasDetectorState == previousGasDetectorState &&
+         overTempDetectorState == previousOverTempDetectorState ) {
+        return;
+    }
+    previousAlarmState = alarmState;
+    previousGasDetectorState = gasDetectorState;
+    previousOverTempDetectorState = overTempDetectorState;
+
+    sprintf( payload, "{\"ms\":%lu,\"alarm\":%d,\"gas\":%d,\"overTemp\":%d}",
+             (unsigned long)( timerWheelTicks() * TIME_INCREMENT_MS ),
+             alarmState, gasDetectorState, overTempDetectorState );
+    mqttPublisherAlarmEventPublish( payload );
+}
+
+static void mqttReadingPublish( void * context )
+{
+    statusReport_t state;
+
+    sharedStateRead( &state );
+    mqttPublisherReadingAdd( state.uptimeMs, state.votedTempCentiC );
+}
+
+static void uartCommandExecute( char receivedChar )
+{
+    char str[100];
+
+    switch (receivedChar) {
+    case '1':
+        if ( alarmState ) {
+            consoleWrite( "The alarm is activated\r\n", 24);
+        } else {
+            consoleWrite( "The alarm is not activated\r\n", 28);
+        }
+        break;
+
+    case '2':
+        if ( mq2Faults != SENSOR_FAULT_NONE ) {
+            sprintf ( str, "Gas sensor fault: %s\r\n",
+                      sensorFaultDescription( mq2Faults ) );
+            consoleWrite( str, strlen( str ) );
+        } else if ( !mq2Read() ) {
+            consoleWrite( "Gas is being detected\r\n", 22);
+        } else {
+            consoleWrite( "Gas is not being detected\r\n", 27);
+        }
+        break;
+
+    case '3':
+        if ( temperatureFaults != SENSOR_FAULT_NONE ) {
+            sprintf ( str, "Temperature sensor fault: %s\r\n",
+                      sensorFaultDescription( temperatureFaults ) );
+            consoleWrite( str, strlen( str ) );
+        } else if ( overTempDetector ) {
+            consoleWrite( "Temperature is above the maximum level\r\n", 40);
+        } else {
+            consoleWrite( "Temperature is below the maximum level\r\n", 40);
+        }
+        break;
+        
+    case '4':
+        uartDialogStart( codeEntryDialog );
+        break;
+
+    case '5':
+        uartDialogStart( newCodeDialog );
+        break;
  
-        case 'p':
-        case 'P':
-            potentiometerReading = potentiometer.read();
-            sprintf ( str, "Potentiometer: %.2f\r\n", potentiometerReading );
-            stringLength = 100; // HARDCODEADO DV strlen(str);
-            uartUsb.write( str, stringLength );
-            break;
+    case 'p':
+    case 'P':
+        potentiometerReading = potentiometer.read();
+        sprintf ( str, "Potentiometer: %.2f\r\n", potentiometerReading );
+        consoleWrite( str, strlen( str ) );
+        break;
 
-        case 'c':
-        case 'C':
-            sprintf ( str, "Temperature: %.2f \xB0 C\r\n", lm35TempC );
-            stringLength = 100; // HARDCODEADO DV strlen(str);
-            uartUsb.write( str, stringLength );
-            break;
+    case 'c':
+    case 'C':
+        sprintf ( str, "Temperature: %.2f \xB0 C, changing %.2f \xB0 C/s\r\n",
+                  lm35TempC, lm35TempRateCPerS );
+        consoleWrite( str, strlen( str ) );
+        break;
 
-        case 'f':
-        case 'F':
-            sprintf ( str, "Temperature: %.2f \xB0 F\r\n", 
-                celsiusToFahrenheit( lm35TempC ) );
-            stringLength = 100; // HARDCODEADO DV strlen(str);
-            uartUsb.write( str, stringLength );
-            break;
+    case 'f':
+    case 'F':
+        sprintf ( str, "Temperature: %.2f \xB0 F\r\n", 
+            celsiusToFahrenheit( lm35TempC ) );
+        consoleWrite( str, strlen( str ) );
+        break;
+
+    case 't':
+    case 'T':
+        potentiometerThresholdTuningSet( !potentiometerThresholdTuning );
+        if ( potentiometerThresholdTuning ) {
+            consoleWrite( "Potentiometer threshold tuning enabled\r\n", 40 );
+        } else {
+            consoleWrite( "Potentiometer threshold tuning disabled\r\n", 41 );
+        }
+        break;
+
+    case 'm':
+    case 'M':
+        memoryUsageReport();
+        break;
+
+    case 's':
+        statusSnapshotSend( false );
+        break;
+
+    case 'S':
+        statusSnapshotSend( true );
+        break;
+
+    case 'h':
+    case 'H':
+        uartDialogStart( historyReportDialog );
+        break;
+
+    case 'r':
+    case 'R':
+        uartDialogStart( rollupReportDialog );
+        break;
+
+    case 'b':
+    case 'B':
+        uartDialogStart( baudRateDialog );
+        break;
+
+    case 'x':
+    case 'X':
+        uartDialogStart( throughputTestDialog );
+        break;
+
+    case 'e':
+    case 'E':
+        uartDialogStart( traceDumpDialog );
+        break;
+
+    default:
+        availableCommands();
+        break;
+
+    }
+}
+
+// @note The encoding time of every sample is measured, giving the codec
+// benchmark on the target reported by historyReportDialog().
+static void historySamplingUpdate( void * context )
+{
+    statusReport_t state;
+    uint32_t startCycles;
+
+    sharedStateRead( &state );
+    startCycles = cycleCounterRead();
+    sampleHistoryAdd( state.uptimeMs, state.votedTempCentiC );
+    historyEncodeCycles += cycleCounterRead() - startCycles;
+    historyEncodedSamples++;
+}
+
+// @note Runs at its own low rate and only fills the LCD shadow framebuffer
+// from the shared state; characterLcdUpdate() sends the cells that changed,
+// one asynchronous transfer at a time, so the display never delays the
+// alarm logic.
+static void lcdRefresh( void * context )
+{
+    statusReport_t state;
+    char line[CHARACTER_LCD_COLS + 1];
+    const char * codeStatus = "";
+
+    sharedStateRead( &state );
+
+    snprintf( line, sizeof( line ), "%-5s %-3s %-4s",
+              ( state.flags & STATUS_FLAG_ALARM ) ? "ALARM" : "Ready",
+              ( state.flags & STATUS_FLAG_GAS_ALARM ) ? "GAS" : "",
+              ( state.flags & STATUS_FLAG_OVER_TEMP_ALARM ) ? "TEMP" : "" );
+    characterLcdWrite( 0, 0, line );
+
+    if ( state.flags & STATUS_FLAG_SYSTEM_BLOCKED ) {
+        codeStatus = "LOCKED";
+    } else if ( state.flags & STATUS_FLAG_INCORRECT_CODE ) {
+        codeStatus = "BADCODE";
+    }
+    snprintf( line, sizeof( line ), "%6.1fC %-8s",
+              state.votedTempCentiC / 100.0, codeStatus );
+    characterLcdWrite( 1, 0, line );
+}
+
+#if BENCHMARK
+
+// @note Runs before the control loop starts, and before the heap guard is
+// armed since sprintf() may allocate on first use. The results go to the
+// console as "BENCH," lines ending with "BENCH,END", read by
+// tools/benchmark_run.py. Under Renode the cycle counter advances with the
+// executed instructions, so the counts are instruction counts there. The
+// alarm state is restored after every benchmark; keypad events that arrive
+// while the alarm deactivation benchmark runs are consumed by it.
+static void benchmarksRun()
+{
+    // The float average is the averaging loop the moving average replaced,
+    // kept for comparison.
+    static const benchmarkCase_t benchmarkCases[] = {
+        { "lm35_formula", benchmarkLm35Formula },
+        { "float_average", benchmarkFloatAverage },
+        { "moving_average", benchmarkMovingAverage },
+        { "kalman_filter", benchmarkKalmanFilter },
+        { "sprintf_float", benchmarkSprintfFloat },
+        { "status_report", benchmarkStatusReport },
+        { "alarm_activation", benchmarkAlarmActivation },
+        { "alarm_deactivation", benchmarkAlarmDeactivation },
+    };
+    const int numberOfBenchmarkCases = sizeof( benchmarkCases ) /
+                                       sizeof( benchmarkCases[0] );
+    benchmarkResult_t result;
+    alarmStateSnapshot_t alarmSnapshot;
+    char str[BENCHMARK_LINE_SIZE];
+    int i;
+
+    for ( i = 0; i < NUMBER_OF_AVG_SAMPLES; i++ ) {
+        benchmarkSamples[i] = 0.25 + i * 0.001;
+    }
+    movingAverageInit( &benchmarkFilter, NUMBER_OF_AVG_SAMPLES );
+    kalmanFilterInit( &benchmarkKalman, KALMAN_PROCESS_NOISE,
+                      KALMAN_MEASUREMENT_NOISE, TIME_INCREMENT_MS );
+
+    for ( i = 0; i < numberOfBenchmarkCases; i++ ) {
+        alarmStateSave( &alarmSnapshot );
+        benchmarkRun( benchmarkCases[i].function, NULL, BENCHMARK_ITERATIONS,
+                      &result );
+        alarmStateRestore( &alarmSnapshot );
+        benchmarkFormat( benchmarkCases[i].name, &result, str, sizeof( str ) );
+        consoleWrite( str, strlen( str ) );
+        consoleFlush();
+    }
+    consoleWrite( "BENCH,END\r\n", 11 );
+    consoleFlush();
+}
+
+static void benchmarkLm35Formula( void * context )
+{
+    benchmarkSink = analogReadingScaledWithTheLM35Formula( benchmarkSamples[0] );
+}
+
+static void benchmarkFloatAverage( void * context )
+{
+    float sum = 0.0;
+    int i;
+
+    for ( i = 0; i < NUMBER_OF_AVG_SAMPLES; i++ ) {
+        sum = sum + benchmarkSamples[i];
+    }
+    benchmarkSink = sum / NUMBER_OF_AVG_SAMPLES;
+}
+
+static void benchmarkMovingAverage( void * context )
+{
+    movingAverageUpdate( &benchmarkFilter, LM35_TEMP_TO_COUNTS( 25 ) );
+    benchmarkSink = movingAverageReadNormalized( &benchmarkFilter );
+}
+
+static void benchmarkKalmanFilter( void * context )
+{
+    kalmanFilterUpdate( &benchmarkKalman, 2500 );
+    benchmarkSink = kalmanFilterValue( &benchmarkKalman );
+}
+
+static void benchmarkSprintfFloat( void * context )
+{
+    char str[16];
+
+    sprintf( str, "%.2f", benchmarkSamples[0] * 100 );
+    benchmarkSink = str[0];
+}
+
+static void benchmarkStatusReport( void * context )
+{
+    statusReport_t report;
+    uint8_t buffer[STATUS_REPORT_ENCODED_SIZE];
+
+    statusReportFill( &report );
+    statusReportEncode( &report, buffer, sizeof( buffer ) );
+    benchmarkSink = buffer[0];
+}
+
+static void benchmarkAlarmActivation( void * context )
+{
+    alarmActivationUpdate();
+}
+
+static void benchmarkAlarmDeactivation( void * context )
+{
+    alarmDeactivationUpdate();
+}
+
+static void alarmStateSave( alarmStateSnapshot_t * snapshot )
+{
+    snapshot->alarmState = alarmState;
+    snapshot->overTempDetector = overTempDetector;
+    snapshot->gasDetectorState = gasDetectorState;
+    snapshot->overTempDetectorState = overTempDetectorState;
+    snapshot->numberOfIncorrectCodes = numberOfIncorrectCodes;
+    snapshot->numberOfKeysPressed = numberOfKeysPressed;
+    memcpy( snapshot->keysPressed, keysPressed, NUMBER_OF_KEYS );
+    snapshot->mq2Transitions = mq2Transitions;
+    snapshot->alarmLed = alarmLed;
+    snapshot->incorrectCodeLed = incorrectCodeLed;
+    snapshot->systemBlockedLed = systemBlockedLed;
+}
+
+// @note With the alarm off the siren and blinking are turned off as
+// alarmActivationUpdate() does; an alarm that was on keeps them.
+static void alarmStateRestore( const alarmStateSnapshot_t * snapshot )
+{
+    alarmState = snapshot->alarmState;
+    overTempDetector = snapshot->overTempDetector;
+    gasDetectorState = snapshot->gasDetectorState;
+    overTempDetectorState = snapshot->overTempDetectorState;
+    numberOfIncorrectCodes = snapshot->numberOfIncorrectCodes;
+    numberOfKeysPressed = snapshot->numberOfKeysPressed;
+    memcpy( keysPressed, snapshot->keysPressed, NUMBER_OF_KEYS );
+    mq2Transitions = snapshot->mq2Transitions;
+    alarmLed = snapshot->alarmLed;
+    incorrectCodeLed = snapshot->incorrectCodeLed;
+    systemBlockedLed = snapshot->systemBlockedLed;
+    if ( !alarmState ) {
+        timerWheelStop( &alarmBlinkTimer );
+        sirenPin.input();
+    }
+}
+
+#endif
+
+// @note A summary line with the compression achieved against storing each
+// sample as a float, then one "time (ms),temperature (hundredths of a degree)"
+// line per sample, oldest first. The whole history is about 14 KB of text,
+// so it is sent one TX buffer per call, and any key stops it.
+static protothreadStatus_t historyReportDialog( protothread_t * pt )
+{
+    static sampleHistoryCursor_t cursor;
+    char str[120];
+    uint32_t samples;
+    int bytes;
+
+    PT_BEGIN( pt );
 
-        default:
-            availableCommands();
+    samples = sampleHistorySamples();
+    bytes = sampleHistoryBytes();
+    if ( samples == 0 || historyEncodedSamples == 0 ) {
+        consoleWrite( "History is empty\r\n", 18 );
+    } else {
+        sprintf( str, "History: %lu samples in %d bytes, "
+                 "%lu.%02lu bytes/sample, %lu.%01lux smaller than floats, "
+                 "%lu cycles/sample\r\n",
+                 (unsigned long)samples, bytes,
+                 (unsigned long)( bytes / samples ),
+                 (unsigned long)( bytes * 100 / samples % 100 ),
+                 (unsigned long)( samples * sizeof( float ) / bytes ),
+                 (unsigned long)( samples * sizeof( float ) * 10 / bytes % 10 ),
+                 (unsigned long)( historyEncodeCycles /
+                                  historyEncodedSamples ) );
+        consoleWrite( str, strlen( str ) );
+        sampleHistoryCursorInit( &cursor );
+        PT_YIELD( pt );
+
+        while ( !uartDialogCharRead() &&
+                sampleHistoryForEachNext( &cursor,
+                                          HISTORY_REPORT_LINES_PER_CALL,
+                                          historySampleWrite, NULL ) ) {
+            PT_YIELD( pt );
+        }
+    }
+
+    PT_END( pt );
+}
+
+static void historySampleWrite( uint32_t timeMs, int32_t value, void * context )
+{
+    char str[HISTORY_REPORT_LINE_SIZE + 1];
+
+    sprintf( str, "%lu,%ld\r\n", (unsigned long)timeMs, (long)value );
+    consoleWrite( str, strlen( str ) );
+}
+
+// @note Every resolution in one response: a header line per resolution,
+// then one "start (ms),min,max,mean,samples" line per bucket, oldest first,
+// in hundredths of a degree of the LM35. The bucket still being filled is
+// marked with '*'. The report is about 4 KB of text, so it is sent one TX
+// buffer per call, and any key stops it.
+static protothreadStatus_t rollupReportDialog( protothread_t * pt )
+{
+    static rollupCursor_t cursor;
+    static int level;
+    static bool stopped;
+    char str[60];
+
+    PT_BEGIN( pt );
+
+    stopped = false;
+    for ( level = 0; level < ROLLUP_LEVELS && !stopped; level++ ) {
+        if ( level > 0 ) {
+            PT_YIELD( pt );
+        }
+        sprintf( str, "Rollup %lu s, last %d:\r\n",
+                 (unsigned long)( rollupResolutionMs( level ) / 1000 ),
+                 rollupLength( level ) );
+        consoleWrite( str, strlen( str ) );
+        rollupCursorInit( &cursor, level );
+        PT_YIELD( pt );
+
+        while ( !( stopped = uartDialogCharRead() ) &&
+                rollupForEachNext( &cursor, ROLLUP_REPORT_LINES_PER_CALL,
+                                   rollupBucketWrite, NULL ) ) {
+            PT_YIELD( pt );
+        }
+    }
+
+    PT_END( pt );
+}
+
+static void rollupBucketWrite( const rollupBucket_t * bucket, bool closed,
+                               void * context )
+{
+    char str[ROLLUP_REPORT_LINE_SIZE];
+
+    sprintf( str, "%lu,%ld,%ld,%ld,%lu%s\r\n",
+             (unsigned long)bucket->startTimeMs, (long)bucket->min,
+             (long)bucket->max, (long)( bucket->sum / bucket->count ),
+             (unsigned long)bucket->count, closed ? "" : ",*" );
+    consoleWrite( str, strlen( str ) );
+}
+
+// @note The dump is about 4.5 KB with a full ring, so it is sent one TX
+// buffer per call; tracing stays paused until its end line is sent. Keys
+// are discarded rather than stopping it, as tools/trace_convert.py cannot
+// use a dump cut short.
+static protothreadStatus_t traceDumpDialog( protothread_t * pt )
+{
+    static traceDumpCursor_t cursor;
+
+    PT_BEGIN( pt );
+
+    traceDumpStart( &cursor );
+    while ( traceDumpNext( &cursor, UART_TX_BUFFER_SIZE, consoleWrite ) ) {
+        while ( uartDialogCharRead() ) {
+        }
+        PT_YIELD( pt );
+    }
+
+    PT_END( pt );
+}
+
+// @note A character arriving with the queue full is dropped.
+static void uartRxInterrupt()
+{
+    char receivedChar;
+
+    traceBegin( TRACE_EVENT_UART_RX_ISR );
+    uartUsb.read( &receivedChar, 1 );
+    uartRxQueue.push( receivedChar );
+    traceEnd( TRACE_EVENT_UART_RX_ISR );
+}
+
+// @note Output longer than the buffer is sent in pieces as it fills up.
+static void consoleWrite( const char * buffer, int length )
+{
+    int chunk;
+
+    while ( length > 0 ) {
+        if ( uartTxLength == UART_TX_BUFFER_SIZE ) {
+            consoleFlush();
+        }
+        chunk = UART_TX_BUFFER_SIZE - uartTxLength;
+        if ( chunk > length ) {
+            chunk = length;
+        }
+        memcpy( uartTxBuffer + uartTxLength, buffer, chunk );
+        uartTxLength += chunk;
+        buffer += chunk;
+        length -= chunk;
+    }
+}
+
+static void consoleFlush()
+{
+    if ( uartTxLength > 0 ) {
+        traceBegin( TRACE_EVENT_CONSOLE_FLUSH );
+        uartUsb.write( uartTxBuffer, uartTxLength );
+        uartTxLength = 0;
+        traceEnd( TRACE_EVENT_CONSOLE_FLUSH );
+    }
+}
+
+// @note Auto-baud by synchronization character: the host sends
+// UART_AUTO_BAUD_SYNC until it gets an answer. Any other character means the
+// rates differ, so the next rate of uartBaudRates is tried. The STM32F4 USART
+// has no hardware auto-baud detection.
+static void uartAutoBaudUpdate()
+{
+    char receivedChar;
+    char str[40];
+    int i;
+
+    if ( !uartRxQueue.pop( receivedChar ) ) {
+        return;
+    }
+    if ( receivedChar == UART_AUTO_BAUD_SYNC ) {
+        uartAutoBaudPending = false;
+        sprintf( str, "Console at %d baud\r\n", uartBaudRate );
+        consoleWrite( str, strlen( str ) );
+        return;
+    }
+
+    for ( i = 0; i < uartNumberOfBaudRates - 1; i++ ) {
+        if ( uartBaudRates[i] == uartBaudRate ) {
             break;
+        }
+    }
+    uartBaudRate = uartBaudRates[( i + 1 ) % uartNumberOfBaudRates];
+    uartUsb.baud( uartBaudRate );
+    while ( uartRxQueue.pop( receivedChar ) ) {
+    }
+}
 
+static void uartDialogStart( protothreadFunction_t dialog )
+{
+    PT_INIT( &uartDialogThread );
+    uartDialog = dialog;
+    if ( uartDialog( &uartDialogThread ) == PT_ENDED ) {
+        uartDialog = NULL;
+    }
+}
+
+// @note Non-blocking replacement of uartUsb.read() for the dialogs: it is
+// used as PT_WAIT_UNTIL( pt, uartDialogCharRead() ), which yields to the
+// superloop until a character has been received into uartDialogChar.
+static bool uartDialogCharRead()
+{
+    return uartRxQueue.pop( uartDialogChar );
+}
+
+// @note Discards anything else the host sends while it switches rates.
+static bool uartBaudRateConfirmed()
+{
+    while ( uartDialogCharRead() ) {
+        if ( uartDialogChar == UART_BAUD_CONFIRM_CHAR ) {
+            return true;
         }
     }
+    return false;
 }
 
-void availableCommands()
+static protothreadStatus_t codeEntryDialog( protothread_t * pt )
 {
-    uartUsb.write( "Available commands:\r\n", 21 );
-    uartUsb.write( "Press '1' to get the alarm state\r\n", 34 );
-    uartUsb.write( "Press '2' to get the gas detector state\r\n", 41 );
-    uartUsb.write( "Press '3' to get the over temperature detector state\r\n", 54 );
-    uartUsb.write( "Press '4' to enter the code sequence\r\n", 38 );
-    uartUsb.write( "Press '5' to enter a new code\r\n", 31 );
-    uartUsb.write( "Press 'P' or 'p' to get potentiometer reading\r\n", 47 );
-    uartUsb.write( "Press 'f' or 'F' to get lm35 reading in Fahrenheit\r\n", 52 );
-    uartUsb.write( "Press 'c' or 'C' to get lm35 reading in Celsius\r\n\r\n", 51 );
+    static char code[NUMBER_OF_KEYS];
+
+    PT_BEGIN( pt );
+
+    consoleWrite( "Please enter the code sequence.\r\n", 33 );
+    consoleWrite( "Type the 4 keys of the code as on the keypad,\r\n", 47 );
+    consoleWrite( "using '0' to '9' and 'A' to 'D'\r\n\r\n", 35 );
+
+    incorrectCode = false;
+
+    for ( keyBeingEntered = 0;
+          keyBeingEntered < NUMBER_OF_KEYS;
+          keyBeingEntered++) {
+
+        PT_WAIT_UNTIL( pt, uartDialogCharRead() );
+        consoleWrite( "*", 1 );
+
+        code[keyBeingEntered] = uartDialogChar;
+        if ( !codeKeyIsValid( uartDialogChar ) ) {
+            incorrectCode = true;
+        }
+    }
+
+    if ( !codeMatches( code ) ) {
+        incorrectCode = true;
+    }
+
+    if ( incorrectCode == false ) {
+        consoleWrite( "\r\nThe code is correct\r\n\r\n", 25 );
+        alarmState = OFF;
+        incorrectCodeLed = OFF;
+        numberOfIncorrectCodes = 0;
+    } else {
+        consoleWrite( "\r\nThe code is incorrect\r\n\r\n", 27 );
+        incorrectCodeLed = ON;
+        numberOfIncorrectCodes++;
+    }
+
+    PT_END( pt );
 }
 
-bool areEqual()
+// @note The new rate is kept only if the host confirms it by sending
+// UART_BAUD_CONFIRM_CHAR at that rate within UART_BAUD_CONFIRM_TIME;
+// otherwise the console falls back to the previous rate, so a host that
+// cannot follow never loses the console.
+static protothreadStatus_t baudRateDialog( protothread_t * pt )
 {
+    static int previousBaudRate;
+    static int newBaudRate;
+    static uint32_t switchTicks;
+    static bool confirmed;
+    char str[60];
     int i;
 
-    for (i = 0; i < NUMBER_OF_KEYS; i++) {
-        if (codeSequence[i] != buttonsPressed[i]) {
-            return false;
+    PT_BEGIN( pt );
+
+    consoleWrite( "Select the baud rate:\r\n", 23 );
+    for ( i = 0; i < uartNumberOfBaudRates; i++ ) {
+        sprintf( str, "Press '%d' for %d baud\r\n", i + 1, uartBaudRates[i] );
+        consoleWrite( str, strlen( str ) );
+    }
+    PT_WAIT_UNTIL( pt, uartDialogCharRead() );
+
+    i = uartDialogChar - '1';
+    if ( i < 0 || i >= uartNumberOfBaudRates ) {
+        consoleWrite( "Baud rate unchanged\r\n\r\n", 23 );
+    } else {
+        previousBaudRate = uartBaudRate;
+        newBaudRate = uartBaudRates[i];
+        sprintf( str, "Switching to %d baud, send '%c' to confirm\r\n",
+                 newBaudRate, UART_BAUD_CONFIRM_CHAR );
+        consoleWrite( str, strlen( str ) );
+
+        // The message must leave at the current rate: uartTask() may run the
+        // dialog again before its own flush if more characters are queued.
+        // The wait covers the character still in the shift register.
+        consoleFlush();
+        wait_us( UART_BITS_PER_CHAR * 1000000 / previousBaudRate + 1 );
+        uartBaudRate = newBaudRate;
+        uartUsb.baud( uartBaudRate );
+        switchTicks = timerWheelTicks();
+
+        PT_WAIT_UNTIL( pt, ( confirmed = uartBaudRateConfirmed() ) ||
+                           timerWheelTicks() - switchTicks >=
+                           UART_BAUD_CONFIRM_TIME / TIME_INCREMENT_MS );
+        if ( !confirmed ) {
+            uartBaudRate = previousBaudRate;
+            uartUsb.baud( uartBaudRate );
         }
+        sprintf( str, "Console at %d baud\r\n\r\n", uartBaudRate );
+        consoleWrite( str, strlen( str ) );
     }
 
-    return true;
+    PT_END( pt );
 }
 
-float analogReadingScaledWithTheLM35Formula( float analogReading )
+// @note Sends UART_THROUGHPUT_TEST_BYTES in chunks of what the UART can send
+// in one tick, one chunk per call, so the control loop keeps running while
+// the test lasts; only the uartUsb.write() calls are timed. The test is not
+// started while the alarm is active, and the alarm or any key stops it.
+static protothreadStatus_t throughputTestDialog( protothread_t * pt )
 {
-    return ( analogReading * 3.3 / 0.01 );
+    static Timer timer;
+    static int sent;
+    static int chunk;
+    char str[100];
+    uint32_t elapsedUs;
+    uint32_t bytesPerSecond;
+    int i;
+
+    PT_BEGIN( pt );
+
+    if ( alarmState ) {
+        consoleWrite( "Not available while the alarm is active\r\n\r\n", 43 );
+    } else {
+        timer.reset();
+        for ( sent = 0; sent < UART_THROUGHPUT_TEST_BYTES; sent += chunk ) {
+            if ( alarmState || uartDialogCharRead() ) {
+                break;
+            }
+            chunk = uartBaudRate / UART_BITS_PER_CHAR * TIME_INCREMENT_MS /
+                    1000;
+            if ( chunk > UART_TX_BUFFER_SIZE ) {
+                chunk = UART_TX_BUFFER_SIZE;
+            }
+            if ( chunk > UART_THROUGHPUT_TEST_BYTES - sent ) {
+                chunk = UART_THROUGHPUT_TEST_BYTES - sent;
+            }
+            consoleFlush();
+            for ( i = 0; i < chunk; i++ ) {
+                uartTxBuffer[i] = ( ( sent + i ) % 64 == 62 ) ? '\r' :
+                                  ( ( sent + i ) % 64 == 63 ) ? '\n' :
+                                  'A' + ( sent + i ) % 26;
+            }
+            timer.start();
+            uartUsb.write( uartTxBuffer, chunk );
+            timer.stop();
+            PT_YIELD( pt );
+        }
+
+        if ( sent < UART_THROUGHPUT_TEST_BYTES ) {
+            consoleWrite( "\r\nThroughput test stopped\r\n", 27 );
+        }
+        elapsedUs = timer.elapsed_time().count();
+        if ( elapsedUs > 0 ) {
+            bytesPerSecond = (uint64_t)sent * 1000000 / elapsedUs;
+            sprintf( str, "Sent %d bytes in %lu us: %lu bytes/s, "
+                     "%lu%% of %d baud\r\n\r\n", sent,
+                     (unsigned long)elapsedUs, (unsigned long)bytesPerSecond,
+                     (unsigned long)( bytesPerSecond * UART_BITS_PER_CHAR *
+                                      100 / uartBaudRate ),
+                     uartBaudRate );
+            consoleWrite( str, strlen( str ) );
+        }
+    }
+
+    PT_END( pt );
 }
 
-float celsiusToFahrenheit( float tempInCelsiusDegrees )
+// @note The code is replaced only once all its keys are valid.
+static protothreadStatus_t newCodeDialog( protothread_t * pt )
 {
-    return ( tempInCelsiusDegrees * 9.0 / 5.0 + 32.0 );
+    static char code[NUMBER_OF_KEYS];
+    static bool valid;
+
+    PT_BEGIN( pt );
+
+    consoleWrite( "Please enter new code sequence\r\n", 32 );
+    consoleWrite( "Type the 4 keys of the code as on the keypad,\r\n", 47 );
+    consoleWrite( "using '0' to '9' and 'A' to 'D'\r\n\r\n", 35 );
+
+    valid = true;
+
+    for ( keyBeingEntered = 0; 
+          keyBeingEntered < NUMBER_OF_KEYS; 
+          keyBeingEntered++) {
+
+        PT_WAIT_UNTIL( pt, uartDialogCharRead() );
+        consoleWrite( "*", 1 );
+
+        code[keyBeingEntered] = uartDialogChar;
+        if ( !codeKeyIsValid( uartDialogChar ) ) {
+            valid = false;
+        }
+    }
+
+    if ( valid ) {
+        memcpy( codeSequence, code, NUMBER_OF_KEYS );
+        consoleWrite( "\r\nNew code generated\r\n\r\n", 24 );
+    } else {
+        consoleWrite( "\r\nInvalid key, code unchanged\r\n\r\n", 33 );
+    }
+
+    PT_END( pt );
 }
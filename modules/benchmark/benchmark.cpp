@@ -0,0 +1,103 @@
+//=====[Libraries]=============================================================
+
+#include "mbed.h"
+
+#include "benchmark.h"
+#include "cycle_counter.h"
+
+#include <stdio.h>
+
+//=====[Declaration of private defines]========================================
+
+#define BENCHMARK_CALIBRATION_CALLS     16
+
+//=====[Declaration and initialization of private global variables]============
+
+static bool calibrated = false;
+static uint32_t overheadCycles = 0;
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static uint32_t benchmarkCall( benchmarkFunction_t function, void * context );
+static void benchmarkEmpty( void * context );
+
+//=====[Implementations of public functions]===================================
+
+// @note Each call runs in a critical section, so interrupts do not add to
+// it. The cost of an empty call, measured once, is subtracted from every
+// sample. One untimed call comes first, with interrupts enabled: first calls
+// may allocate (sprintf() sets up its buffers on its first float) and take
+// a mutex, which fails with interrupts masked, and should not count anyway.
+void benchmarkRun( benchmarkFunction_t function, void * context,
+                   uint32_t iterations, benchmarkResult_t * result )
+{
+    uint32_t cycles;
+    uint32_t i;
+
+    if ( !calibrated ) {
+        overheadCycles = UINT32_MAX;
+        for ( i = 0; i < BENCHMARK_CALIBRATION_CALLS; i++ ) {
+            cycles = benchmarkCall( benchmarkEmpty, NULL );
+            if ( cycles < overheadCycles ) {
+                overheadCycles = cycles;
+            }
+        }
+        calibrated = true;
+    }
+
+    function( context );
+
+    result->iterations = iterations;
+    result->minCycles = UINT32_MAX;
+    result->maxCycles = 0;
+    result->totalCycles = 0;
+
+    for ( i = 0; i < iterations; i++ ) {
+        cycles = benchmarkCall( function, context );
+        cycles = ( cycles > overheadCycles ) ? cycles - overheadCycles : 0;
+        if ( cycles < result->minCycles ) {
+            result->minCycles = cycles;
+        }
+        if ( cycles > result->maxCycles ) {
+            result->maxCycles = cycles;
+        }
+        result->totalCycles += cycles;
+    }
+}
+
+// @note One "BENCH,name,iterations,min,mean,max" line, parsed by
+// tools/benchmark_run.py.
+int benchmarkFormat( const char * name, const benchmarkResult_t * result,
+                     char * buffer, int size )
+{
+    uint32_t meanCycles = 0;
+
+    if ( result->iterations > 0 ) {
+        meanCycles = (uint32_t)( result->totalCycles / result->iterations );
+    }
+    return snprintf( buffer, size, "BENCH,%s,%lu,%lu,%lu,%lu\r\n", name,
+                     (unsigned long)result->iterations,
+                     (unsigned long)result->minCycles,
+                     (unsigned long)meanCycles,
+                     (unsigned long)result->maxCycles );
+}
+
+//=====[Implementations of private functions]==================================
+
+static uint32_t benchmarkCall( benchmarkFunction_t function, void * context )
+{
+    uint32_t startCycles;
+    uint32_t cycles;
+
+    core_util_critical_section_enter();
+    startCycles = cycleCounterRead();
+    function( context );
+    cycles = cycleCounterRead() - startCycles;
+    core_util_critical_section_exit();
+
+    return cycles;
+}
+
+static void benchmarkEmpty( void * context )
+{
+}
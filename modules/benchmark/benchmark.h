@@ -0,0 +1,35 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+#define BENCHMARK_LINE_SIZE     80
+
+//=====[Declaration of public data types]======================================
+
+typedef void (*benchmarkFunction_t)( void * context );
+
+// @note Cycles per call, with the cost of the measurement itself removed.
+typedef struct {
+    uint32_t iterations;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+} benchmarkResult_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void benchmarkRun( benchmarkFunction_t function, void * context,
+                   uint32_t iterations, benchmarkResult_t * result );
+int benchmarkFormat( const char * name, const benchmarkResult_t * result,
+                     char * buffer, int size );
+
+//=====[#include guards - end]=================================================
+
+#endif // _BENCHMARK_H_
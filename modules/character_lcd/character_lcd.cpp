@@ -0,0 +1,274 @@
+//=====[Libraries]=============================================================
+
+#include "character_lcd.h"
+
+#include "i2c_scheduler.h"
+
+#include <stddef.h>
+#include <string.h>
+
+//=====[Declaration of private defines]========================================
+
+// PCF8574 outputs wired to the HD44780 on the usual I2C backpacks: P0 = RS,
+// P1 = RW, P2 = E, P3 = backlight and P4-P7 = D4-D7.
+#define PCF8574_RS                      0x01
+#define PCF8574_E                       0x04
+#define PCF8574_BACKLIGHT               0x08
+
+#define HD44780_FUNCTION_SET_4_BIT      0x28    // 4-bit bus, 2 lines, 5x8 dots
+#define HD44780_DISPLAY_ON              0x0C    // Display on, no cursor
+#define HD44780_ENTRY_MODE_INCREMENT    0x06
+#define HD44780_CLEAR_DISPLAY           0x01
+#define HD44780_SET_DDRAM_ADDRESS       0x80
+
+// Updates to wait after power on before talking to the HD44780, which needs
+// 40 ms.
+#define CHARACTER_LCD_POWER_UP_UPDATES  5
+
+// Each byte for the HD44780 takes two nibbles, and each nibble two PCF8574
+// writes: one with E high and one with E low, latching it.
+#define PCF8574_BYTES_PER_NIBBLE        2
+#define PCF8574_BYTES_PER_LCD_BYTE      ( 2 * PCF8574_BYTES_PER_NIBBLE )
+#define CHARACTER_LCD_TX_BUFFER_SIZE    \
+    ( ( 1 + CHARACTER_LCD_COLS ) * PCF8574_BYTES_PER_LCD_BYTE )
+
+//=====[Declaration of private data types]=====================================
+
+// @note Power on initialization in 4-bit mode, one step per update: the
+// first four steps are single nibbles (function set to 8-bit three times,
+// then to 4-bit), the rest whole commands.
+typedef struct {
+    uint8_t value;
+    bool singleNibble;
+} characterLcdInitStep_t;
+
+//=====[Declaration and initialization of private global variables]============
+
+static const characterLcdInitStep_t initSteps[] = {
+    { 0x30, true },
+    { 0x30, true },
+    { 0x30, true },
+    { 0x20, true },
+    { HD44780_FUNCTION_SET_4_BIT, false },
+    { HD44780_DISPLAY_ON, false },
+    { HD44780_ENTRY_MODE_INCREMENT, false },
+    { HD44780_CLEAR_DISPLAY, false },
+};
+static const int numberOfInitSteps = sizeof( initSteps ) /
+                                     sizeof( initSteps[0] );
+
+static const uint8_t rowAddresses[CHARACTER_LCD_ROWS] = { 0x00, 0x40 };
+
+// @note Shadow framebuffer: screen holds what the application wants shown
+// and shown what the LCD is known to hold. Only the cells that differ are
+// sent, so a refresh that changes nothing costs no bus traffic.
+static char screen[CHARACTER_LCD_ROWS][CHARACTER_LCD_COLS];
+static char shown[CHARACTER_LCD_ROWS][CHARACTER_LCD_COLS];
+
+// @note One transfer in flight at a time; the buffer and the run it carries
+// stay untouched until lcdTransferDone() is called.
+static uint8_t txBuffer[CHARACTER_LCD_TX_BUFFER_SIZE];
+static char runSent[CHARACTER_LCD_COLS];
+static int runRow = 0;
+static int runCol = 0;
+static int runLength = 0;
+
+static int powerUpUpdates = 0;
+static int initStep = 0;
+static volatile bool transferInProgress = false;
+static volatile bool transferFailed = false;
+static characterLcdStats_t lcdStats;
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static int lcdNibbleEncode( uint8_t * buffer, uint8_t nibble, uint8_t rs );
+static int lcdByteEncode( uint8_t * buffer, uint8_t value, uint8_t rs );
+static bool lcdTransferSubmit( int length );
+static bool lcdDirtyRunFind();
+static void lcdTransferDone( void * context, i2cTransferResult_t result );
+
+//=====[Implementations of public functions]===================================
+
+void characterLcdInit()
+{
+    memset( screen, ' ', sizeof( screen ) );
+    memset( shown, ' ', sizeof( shown ) );
+    memset( &lcdStats, 0, sizeof( lcdStats ) );
+    powerUpUpdates = 0;
+    initStep = 0;
+    runLength = 0;
+    transferInProgress = false;
+    transferFailed = false;
+}
+
+// @note Must be called every few milliseconds, and no more often than every
+// 5 ms during the initialization, whose longest wait (4.1 ms) is then met
+// between two steps. Submits at most one transfer and returns at once.
+void characterLcdUpdate()
+{
+    int length;
+    int i;
+
+    if ( transferInProgress ) {
+        return;
+    }
+
+    if ( powerUpUpdates < CHARACTER_LCD_POWER_UP_UPDATES ) {
+        powerUpUpdates++;
+        return;
+    }
+
+    // A refused step, or an LCD missing from the bus, starts the whole
+    // initialization again after the power on wait.
+    if ( initStep > 0 && runLength == 0 && transferFailed ) {
+        lcdStats.errors++;
+        powerUpUpdates = 0;
+        initStep = 0;
+        transferFailed = false;
+        memset( shown, ' ', sizeof( shown ) );
+        return;
+    }
+
+    if ( initStep < numberOfInitSteps ) {
+        if ( initSteps[initStep].singleNibble ) {
+            length = lcdNibbleEncode( txBuffer, initSteps[initStep].value, 0 );
+        } else {
+            length = lcdByteEncode( txBuffer, initSteps[initStep].value, 0 );
+        }
+        if ( lcdTransferSubmit( length ) ) {
+            initStep++;
+        }
+        return;
+    }
+
+    if ( runLength > 0 ) {
+        if ( transferFailed ) {
+            lcdStats.errors++;
+        } else {
+            memcpy( &shown[runRow][runCol], runSent, runLength );
+            lcdStats.charactersSent += runLength;
+        }
+        runLength = 0;
+        transferFailed = false;
+    }
+
+    if ( !lcdDirtyRunFind() ) {
+        return;
+    }
+
+    length = lcdByteEncode( txBuffer,
+                            HD44780_SET_DDRAM_ADDRESS |
+                            ( rowAddresses[runRow] + runCol ), 0 );
+    for ( i = 0; i < runLength; i++ ) {
+        runSent[i] = screen[runRow][runCol + i];
+        length += lcdByteEncode( &txBuffer[length], runSent[i], PCF8574_RS );
+    }
+    if ( !lcdTransferSubmit( length ) ) {
+        runLength = 0;
+    }
+}
+
+// @note Only updates the shadow framebuffer; the text is clipped at the end
+// of the row.
+void characterLcdWrite( int row, int col, const char * text )
+{
+    if ( row < 0 || row >= CHARACTER_LCD_ROWS ) {
+        return;
+    }
+    while ( col >= 0 && col < CHARACTER_LCD_COLS && *text != '\0' ) {
+        screen[row][col] = *text;
+        col++;
+        text++;
+    }
+}
+
+bool characterLcdIsReady()
+{
+    return initStep >= numberOfInitSteps;
+}
+
+void characterLcdStatsGet( characterLcdStats_t * stats )
+{
+    *stats = lcdStats;
+}
+
+//=====[Implementations of private functions]==================================
+
+static int lcdNibbleEncode( uint8_t * buffer, uint8_t nibble, uint8_t rs )
+{
+    uint8_t output = ( nibble & 0xF0 ) | rs | PCF8574_BACKLIGHT;
+
+    buffer[0] = output | PCF8574_E;
+    buffer[1] = output;
+    return PCF8574_BYTES_PER_NIBBLE;
+}
+
+static int lcdByteEncode( uint8_t * buffer, uint8_t value, uint8_t rs )
+{
+    lcdNibbleEncode( buffer, value & 0xF0, rs );
+    lcdNibbleEncode( &buffer[PCF8574_BYTES_PER_NIBBLE], value << 4, rs );
+    return PCF8574_BYTES_PER_LCD_BYTE;
+}
+
+static bool lcdTransferSubmit( int length )
+{
+    i2cTransaction_t transaction = { CHARACTER_LCD_ADDRESS, txBuffer, length,
+                                     NULL, 0, lcdTransferDone, NULL };
+
+    transferFailed = false;
+    transferInProgress = true;
+    if ( !i2cSchedulerSubmit( &transaction ) ) {
+        transferInProgress = false;
+        return false;
+    }
+    lcdStats.transfers++;
+    return true;
+}
+
+// @note Finds the first changed cell and extends the run over the changed
+// cells after it on the same row. A single unchanged cell between two
+// changed ones is sent too: it costs as much as a new address command and
+// saves a transfer.
+static bool lcdDirtyRunFind()
+{
+    int row;
+    int col;
+    int end;
+
+    for ( row = 0; row < CHARACTER_LCD_ROWS; row++ ) {
+        for ( col = 0; col < CHARACTER_LCD_COLS; col++ ) {
+            if ( screen[row][col] != shown[row][col] ) {
+                break;
+            }
+        }
+        if ( col == CHARACTER_LCD_COLS ) {
+            continue;
+        }
+
+        end = col + 1;
+        while ( end < CHARACTER_LCD_COLS ) {
+            if ( screen[row][end] != shown[row][end] ) {
+                end++;
+            } else if ( end + 1 < CHARACTER_LCD_COLS &&
+                        screen[row][end + 1] != shown[row][end + 1] ) {
+                end += 2;
+            } else {
+                break;
+            }
+        }
+
+        runRow = row;
+        runCol = col;
+        runLength = end - col;
+        return true;
+    }
+    return false;
+}
+
+// @note Runs in the I2C interrupt when the real bus is used; the run is
+// committed to the shadow framebuffer by the next characterLcdUpdate().
+static void lcdTransferDone( void * context, i2cTransferResult_t result )
+{
+    transferFailed = ( result != I2C_TRANSFER_OK );
+    transferInProgress = false;
+}
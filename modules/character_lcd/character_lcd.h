@@ -0,0 +1,35 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _CHARACTER_LCD_H_
+#define _CHARACTER_LCD_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+#define CHARACTER_LCD_ADDRESS           ( 0x27 << 1 )
+#define CHARACTER_LCD_ROWS              2
+#define CHARACTER_LCD_COLS              16
+
+//=====[Declaration of public data types]======================================
+
+typedef struct {
+    uint32_t transfers;
+    uint32_t charactersSent;
+    uint32_t errors;
+} characterLcdStats_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void characterLcdInit();
+void characterLcdUpdate();
+
+void characterLcdWrite( int row, int col, const char * text );
+bool characterLcdIsReady();
+void characterLcdStatsGet( characterLcdStats_t * stats );
+
+//=====[#include guards - end]=================================================
+
+#endif // _CHARACTER_LCD_H_
@@ -0,0 +1,39 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _CYCLE_COUNTER_H_
+#define _CYCLE_COUNTER_H_
+
+//=====[Libraries]=============================================================
+
+#include "mbed.h"
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+// @note CPU clock cycle counter of the Cortex-M3/M4/M7 Data Watchpoint and
+// Trace unit, for measuring short code sections: read it before and after
+// and subtract (the 32-bit count wraps after about 24 s at 180 MHz). Reads
+// 0 on cores without a DWT.
+
+// @note Called once, first thing in main(). It starts the counter without
+// resetting it: a reset while a trace is being recorded would show as a
+// wrap of the count in the converted trace.
+static inline void cycleCounterInit()
+{
+#ifdef DWT
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+static inline uint32_t cycleCounterRead()
+{
+#ifdef DWT
+    return DWT->CYCCNT;
+#else
+    return 0;
+#endif
+}
+
+//=====[#include guards - end]=================================================
+
+#endif // _CYCLE_COUNTER_H_
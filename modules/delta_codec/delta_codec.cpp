@@ -0,0 +1,119 @@
+//=====[Libraries]=============================================================
+
+#include "delta_codec.h"
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static uint32_t zigzagEncode( int32_t value );
+static int32_t zigzagDecode( uint32_t value );
+static int varintSize( uint32_t value );
+
+//=====[Implementations of public functions]===================================
+
+void deltaEncoderInit( deltaEncoder_t * encoder, uint8_t * buffer, int size )
+{
+    encoder->buffer = buffer;
+    encoder->size = size;
+    encoder->length = 0;
+    encoder->previousValue = 0;
+    encoder->previousDelta = 0;
+    encoder->samples = 0;
+}
+
+// @note The first sample is stored as is and the second as a plain delta
+// (the previous delta starts at 0). Differences are computed modulo 2^32,
+// so any int32_t series round-trips. Returns false, adding nothing, when the
+// encoded sample does not fit in the buffer.
+bool deltaEncoderAdd( deltaEncoder_t * encoder, int32_t value )
+{
+    int32_t delta = (int32_t)( (uint32_t)value -
+                               (uint32_t)encoder->previousValue );
+    uint32_t code;
+
+    if ( encoder->samples == 0 ) {
+        delta = 0;
+        code = zigzagEncode( value );
+    } else {
+        code = zigzagEncode( (int32_t)( (uint32_t)delta -
+                                        (uint32_t)encoder->previousDelta ) );
+    }
+    if ( encoder->length + varintSize( code ) > encoder->size ) {
+        return false;
+    }
+
+    while ( code >= 0x80 ) {
+        encoder->buffer[encoder->length++] = ( code & 0x7F ) | 0x80;
+        code >>= 7;
+    }
+    encoder->buffer[encoder->length++] = code;
+
+    encoder->previousValue = value;
+    encoder->previousDelta = delta;
+    encoder->samples++;
+    return true;
+}
+
+void deltaDecoderInit( deltaDecoder_t * decoder, const uint8_t * buffer,
+                       int length )
+{
+    decoder->buffer = buffer;
+    decoder->length = length;
+    decoder->position = 0;
+    decoder->previousValue = 0;
+    decoder->previousDelta = 0;
+    decoder->samples = 0;
+}
+
+// @note Returns false at the end of the data or on a truncated sample.
+bool deltaDecoderNext( deltaDecoder_t * decoder, int32_t * value )
+{
+    uint32_t code = 0;
+    int shift = 0;
+    uint8_t byte;
+    int32_t delta;
+
+    do {
+        if ( decoder->position >= decoder->length || shift > 28 ) {
+            return false;
+        }
+        byte = decoder->buffer[decoder->position++];
+        code |= (uint32_t)( byte & 0x7F ) << shift;
+        shift += 7;
+    } while ( byte & 0x80 );
+
+    if ( decoder->samples == 0 ) {
+        *value = zigzagDecode( code );
+        delta = 0;
+    } else {
+        delta = (int32_t)( (uint32_t)decoder->previousDelta +
+                           (uint32_t)zigzagDecode( code ) );
+        *value = (int32_t)( (uint32_t)decoder->previousValue + (uint32_t)delta );
+    }
+    decoder->previousValue = *value;
+    decoder->previousDelta = delta;
+    decoder->samples++;
+    return true;
+}
+
+//=====[Implementations of private functions]==================================
+
+static uint32_t zigzagEncode( int32_t value )
+{
+    return ( (uint32_t)value << 1 ) ^ (uint32_t)( value >> 31 );
+}
+
+static int32_t zigzagDecode( uint32_t value )
+{
+    return (int32_t)( value >> 1 ) ^ -(int32_t)( value & 1 );
+}
+
+static int varintSize( uint32_t value )
+{
+    int size = 1;
+
+    while ( value >= 0x80 ) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
@@ -0,0 +1,51 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _DELTA_CODEC_H_
+#define _DELTA_CODEC_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+#define DELTA_CODEC_MAX_SAMPLE_SIZE     5
+
+//=====[Declaration of public data types]======================================
+
+// @note Streaming codec for slowly changing integer series, such as
+// temperatures in hundredths of a degree sampled at a fixed rate. Each sample
+// is stored as the change of its delta (delta-of-delta), zigzag mapped so
+// that small negative numbers stay small, as a base-128 varint. A steady or
+// linearly drifting signal costs one byte per sample. Only the last value and
+// delta are kept, so memory use does not depend on the length of the series.
+typedef struct {
+    uint8_t * buffer;
+    int size;
+    int length;
+    int32_t previousValue;
+    int32_t previousDelta;
+    uint32_t samples;
+} deltaEncoder_t;
+
+typedef struct {
+    const uint8_t * buffer;
+    int length;
+    int position;
+    int32_t previousValue;
+    int32_t previousDelta;
+    uint32_t samples;
+} deltaDecoder_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void deltaEncoderInit( deltaEncoder_t * encoder, uint8_t * buffer, int size );
+bool deltaEncoderAdd( deltaEncoder_t * encoder, int32_t value );
+
+void deltaDecoderInit( deltaDecoder_t * decoder, const uint8_t * buffer,
+                       int length );
+bool deltaDecoderNext( deltaDecoder_t * decoder, int32_t * value );
+
+//=====[#include guards - end]=================================================
+
+#endif // _DELTA_CODEC_H_
@@ -0,0 +1,76 @@
+//=====[Libraries]=============================================================
+
+#include "mbed.h"
+
+#include "heap_guard.h"
+
+#if MBED_MEM_TRACING_ENABLED
+
+#include "mbed_mem_trace.h"
+
+//=====[Declaration and initialization of private global variables]============
+
+static volatile uint32_t violations = 0;
+static void * volatile lastCaller = NULL;
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static void heapGuardTrace( uint8_t operation, void * result, void * caller,
+                            ... );
+
+//=====[Implementations of public functions]===================================
+
+// @note Called once initialization is over. From then on every malloc(),
+// calloc() or realloc() is counted, with the address of its caller, or stops
+// the program if "heap-guard-fatal" is set in mbed_app.json.
+void heapGuardArm()
+{
+    mbed_mem_trace_set_callback( heapGuardTrace );
+}
+
+uint32_t heapGuardViolations()
+{
+    return violations;
+}
+
+void * heapGuardLastCaller()
+{
+    return lastCaller;
+}
+
+//=====[Implementations of private functions]==================================
+
+static void heapGuardTrace( uint8_t operation, void * result, void * caller,
+                            ... )
+{
+    if ( operation == MBED_MEM_TRACE_FREE ) {
+        return;
+    }
+    violations++;
+    lastCaller = caller;
+#if MBED_CONF_APP_HEAP_GUARD_FATAL
+    MBED_ERROR( MBED_MAKE_ERROR( MBED_MODULE_APPLICATION,
+                                 MBED_ERROR_CODE_OUT_OF_MEMORY ),
+                "Heap allocation after initialization" );
+#endif
+}
+
+#else
+
+//=====[Implementations of public functions]===================================
+
+void heapGuardArm()
+{
+}
+
+uint32_t heapGuardViolations()
+{
+    return 0;
+}
+
+void * heapGuardLastCaller()
+{
+    return NULL;
+}
+
+#endif // MBED_MEM_TRACING_ENABLED
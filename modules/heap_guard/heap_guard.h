@@ -0,0 +1,18 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _HEAP_GUARD_H_
+#define _HEAP_GUARD_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void heapGuardArm();
+uint32_t heapGuardViolations();
+void * heapGuardLastCaller();
+
+//=====[#include guards - end]=================================================
+
+#endif // _HEAP_GUARD_H_
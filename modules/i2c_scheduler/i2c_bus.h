@@ -0,0 +1,43 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _I2C_BUS_H_
+#define _I2C_BUS_H_
+
+//=====[Libraries]=============================================================
+
+#include "i2c_scheduler.h"
+
+//=====[Declaration of public defines]=========================================
+
+#define I2C_BUS_FREQUENCY_HZ            400000
+#define I2C_SIMULATED_TMP117_ADDRESS    ( 0x48 << 1 )
+#define I2C_SIMULATED_PCF8574_ADDRESS   ( 0x27 << 1 )
+
+//=====[Declaration of public data types]======================================
+
+typedef struct {
+    uint32_t transfers;
+    uint32_t bytes;
+    uint32_t nacks;
+} i2cSimulatedBusStats_t;
+
+//=====[Declaration of public global variables]================================
+
+// Backend on the I2C1 peripheral (D14 = SDA, D15 = SCL) using the mbed
+// asynchronous I2C::transfer() API, completed from the I2C interrupt.
+extern const i2cBus_t i2cMbedBus;
+
+// Backend without hardware: a TMP117 and a PCF8574 emulated in software.
+// Transfers complete when i2cSimulatedBusUpdate() is called.
+extern const i2cBus_t i2cSimulatedBus;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void i2cSimulatedBusUpdate();
+void i2cSimulatedBusTemperatureSet( float tempC );
+void i2cSimulatedBusNackSet( bool nack );
+void i2cSimulatedBusStatsGet( i2cSimulatedBusStats_t * stats );
+
+//=====[#include guards - end]=================================================
+
+#endif // _I2C_BUS_H_
@@ -0,0 +1,56 @@
+//=====[Libraries]=============================================================
+
+#include "mbed.h"
+
+#include "i2c_bus.h"
+
+#if DEVICE_I2C_ASYNCH
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static void mbedBusInit();
+static void mbedBusTransferStart( const i2cTransaction_t * transaction );
+static void mbedBusTransferEvent( int event );
+
+//=====[Declaration and initialization of private global objects]==============
+
+static I2C i2c( D14, D15 );
+
+//=====[Declaration and initialization of public global variables]=============
+
+const i2cBus_t i2cMbedBus = { mbedBusInit, mbedBusTransferStart };
+
+//=====[Implementations of private functions]==================================
+
+static void mbedBusInit()
+{
+    i2c.frequency( I2C_BUS_FREQUENCY_HZ );
+}
+
+static void mbedBusTransferStart( const i2cTransaction_t * transaction )
+{
+    int error;
+
+    error = i2c.transfer( transaction->address,
+                          (const char *)transaction->txData,
+                          transaction->txLength,
+                          (char *)transaction->rxData,
+                          transaction->rxLength,
+                          callback( mbedBusTransferEvent ),
+                          I2C_EVENT_ALL );
+    if ( error != 0 ) {
+        i2cSchedulerTransferComplete( I2C_TRANSFER_ERROR );
+    }
+}
+
+// @note Runs in the I2C interrupt.
+static void mbedBusTransferEvent( int event )
+{
+    if ( event & I2C_EVENT_TRANSFER_COMPLETE ) {
+        i2cSchedulerTransferComplete( I2C_TRANSFER_OK );
+    } else {
+        i2cSchedulerTransferComplete( I2C_TRANSFER_ERROR );
+    }
+}
+
+#endif // DEVICE_I2C_ASYNCH
@@ -0,0 +1,134 @@
+//=====[Libraries]=============================================================
+
+#include "i2c_bus.h"
+
+#include <stddef.h>
+#include <string.h>
+
+//=====[Declaration of private defines]========================================
+
+#define TMP117_REGISTER_TEMPERATURE     0x00
+#define TMP117_REGISTER_CONFIGURATION   0x01
+#define TMP117_REGISTER_DEVICE_ID       0x0F
+#define TMP117_DEVICE_ID                0x0117
+#define TMP117_NUMBER_OF_REGISTERS      0x10
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static void simulatedBusInit();
+static void simulatedBusTransferStart( const i2cTransaction_t * transaction );
+static bool simulatedTmp117Transfer( const i2cTransaction_t * transaction );
+
+//=====[Declaration and initialization of public global variables]=============
+
+const i2cBus_t i2cSimulatedBus = { simulatedBusInit, simulatedBusTransferStart };
+
+//=====[Declaration and initialization of private global variables]============
+
+// @note Only one transfer is in flight at a time, as on a real bus.
+static const i2cTransaction_t * transferInProgress = NULL;
+
+static uint16_t tmp117Registers[TMP117_NUMBER_OF_REGISTERS];
+static uint8_t tmp117Pointer = 0;
+static uint8_t pcf8574Output = 0xFF;
+static bool nackAll = false;
+static i2cSimulatedBusStats_t simulatedBusStats;
+
+//=====[Implementations of public functions]===================================
+
+// @note Completes the transfer in progress, as the end-of-transfer interrupt
+// would. Calling it once per control loop tick models a slow bus; calling it
+// in a tight loop stresses the scheduler.
+void i2cSimulatedBusUpdate()
+{
+    const i2cTransaction_t * transaction = transferInProgress;
+    bool acknowledged;
+
+    if ( transaction == NULL ) {
+        return;
+    }
+    transferInProgress = NULL;
+
+    if ( nackAll ) {
+        acknowledged = false;
+    } else if ( transaction->address == I2C_SIMULATED_TMP117_ADDRESS ) {
+        acknowledged = simulatedTmp117Transfer( transaction );
+    } else if ( transaction->address == I2C_SIMULATED_PCF8574_ADDRESS &&
+                transaction->rxLength == 0 ) {
+        if ( transaction->txLength > 0 ) {
+            pcf8574Output = transaction->txData[transaction->txLength - 1];
+        }
+        acknowledged = true;
+    } else {
+        acknowledged = false;
+    }
+
+    simulatedBusStats.transfers++;
+    simulatedBusStats.bytes += transaction->txLength + transaction->rxLength;
+    if ( !acknowledged ) {
+        simulatedBusStats.nacks++;
+    }
+    i2cSchedulerTransferComplete( acknowledged ? I2C_TRANSFER_OK :
+                                                 I2C_TRANSFER_ERROR );
+}
+
+void i2cSimulatedBusTemperatureSet( float tempC )
+{
+    tmp117Registers[TMP117_REGISTER_TEMPERATURE] =
+        (uint16_t)(int16_t)( tempC * 128.0f );
+}
+
+void i2cSimulatedBusNackSet( bool nack )
+{
+    nackAll = nack;
+}
+
+void i2cSimulatedBusStatsGet( i2cSimulatedBusStats_t * stats )
+{
+    *stats = simulatedBusStats;
+}
+
+//=====[Implementations of private functions]==================================
+
+static void simulatedBusInit()
+{
+    memset( tmp117Registers, 0, sizeof( tmp117Registers ) );
+    memset( &simulatedBusStats, 0, sizeof( simulatedBusStats ) );
+    tmp117Registers[TMP117_REGISTER_CONFIGURATION] = 0x0220;
+    tmp117Registers[TMP117_REGISTER_DEVICE_ID] = TMP117_DEVICE_ID;
+    i2cSimulatedBusTemperatureSet( 25.0f );
+    transferInProgress = NULL;
+}
+
+static void simulatedBusTransferStart( const i2cTransaction_t * transaction )
+{
+    transferInProgress = transaction;
+}
+
+// @note TMP117 protocol: the first written byte sets the register pointer,
+// two more bytes write the register (MSB first) and reads return the
+// register addressed by the pointer.
+static bool simulatedTmp117Transfer( const i2cTransaction_t * transaction )
+{
+    uint16_t value;
+    int i;
+
+    if ( transaction->txLength > 0 ) {
+        if ( transaction->txData[0] >= TMP117_NUMBER_OF_REGISTERS ) {
+            return false;
+        }
+        tmp117Pointer = transaction->txData[0];
+    }
+    if ( transaction->txLength >= 3 &&
+         tmp117Pointer != TMP117_REGISTER_TEMPERATURE &&
+         tmp117Pointer != TMP117_REGISTER_DEVICE_ID ) {
+        tmp117Registers[tmp117Pointer] = ( transaction->txData[1] << 8 ) |
+                                         transaction->txData[2];
+    }
+
+    value = tmp117Registers[tmp117Pointer];
+    for ( i = 0; i < transaction->rxLength; i++ ) {
+        transaction->rxData[i] = ( i % 2 == 0 ) ? ( value >> 8 ) : ( value & 0xFF );
+    }
+    return true;
+}
@@ -0,0 +1,128 @@
+//=====[Libraries]=============================================================
+
+#include "mbed.h"
+
+#include "i2c_scheduler.h"
+#include "trace.h"
+
+//=====[Declaration and initialization of private global variables]============
+
+// @note Circular queue of transactions; the one at queueHead is the next to
+// go on the bus, and the one in progress while transferActive is set. Tasks
+// add at queueTail and the completion interrupt removes at queueHead, both
+// inside a critical section.
+static i2cTransaction_t queue[I2C_SCHEDULER_QUEUE_SIZE];
+static volatile int queueHead = 0;
+static volatile int queueTail = 0;
+static volatile int queueDepth = 0;
+static volatile bool transferActive = false;
+
+static const i2cBus_t * i2cBus = NULL;
+static i2cSchedulerStats_t i2cStats;
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static void transferStartIfIdle();
+
+//=====[Implementations of public functions]===================================
+
+void i2cSchedulerInit( const i2cBus_t * bus )
+{
+    i2cBus = bus;
+    queueHead = 0;
+    queueTail = 0;
+    queueDepth = 0;
+    transferActive = false;
+    memset( &i2cStats, 0, sizeof( i2cStats ) );
+    i2cBus->init();
+}
+
+// @note Starts the transfer at once if the bus is idle and the caller is a
+// task; from an interrupt, such as a completion callback, the transfer waits
+// for the next i2cSchedulerUpdate().
+bool i2cSchedulerSubmit( const i2cTransaction_t * transaction )
+{
+    core_util_critical_section_enter();
+    if ( queueDepth >= I2C_SCHEDULER_QUEUE_SIZE ) {
+        i2cStats.rejected++;
+        core_util_critical_section_exit();
+        return false;
+    }
+    queue[queueTail] = *transaction;
+    queueTail = ( queueTail + 1 ) % I2C_SCHEDULER_QUEUE_SIZE;
+    queueDepth++;
+    i2cStats.submitted++;
+    if ( queueDepth > i2cStats.maxQueueDepth ) {
+        i2cStats.maxQueueDepth = queueDepth;
+    }
+    core_util_critical_section_exit();
+
+    if ( !core_util_is_isr_active() ) {
+        transferStartIfIdle();
+    }
+    return true;
+}
+
+// @note Called from the superloop: starts the next queued transfer once the
+// previous one has completed. The mbed I2C::transfer() locks a mutex, which
+// is not allowed in an interrupt, so the completion interrupt never starts
+// a transfer itself.
+void i2cSchedulerUpdate()
+{
+    transferStartIfIdle();
+}
+
+// @note Only records the result and frees the queue slot, so it is safe in
+// the completion interrupt.
+void i2cSchedulerTransferComplete( i2cTransferResult_t result )
+{
+    i2cTransaction_t finished;
+
+    traceInstant( TRACE_EVENT_I2C_COMPLETE, result );
+    core_util_critical_section_enter();
+    finished = queue[queueHead];
+    queueHead = ( queueHead + 1 ) % I2C_SCHEDULER_QUEUE_SIZE;
+    queueDepth--;
+    transferActive = false;
+    i2cStats.completed++;
+    if ( result != I2C_TRANSFER_OK ) {
+        i2cStats.errors++;
+    }
+    core_util_critical_section_exit();
+
+    if ( finished.callback != NULL ) {
+        finished.callback( finished.context, result );
+    }
+}
+
+int i2cSchedulerQueueDepth()
+{
+    return queueDepth;
+}
+
+void i2cSchedulerStatsGet( i2cSchedulerStats_t * stats )
+{
+    core_util_critical_section_enter();
+    *stats = i2cStats;
+    core_util_critical_section_exit();
+}
+
+//=====[Implementations of private functions]==================================
+
+// @note The bus is claimed inside the critical section, so a task and the
+// superloop poll never start the same transfer twice.
+static void transferStartIfIdle()
+{
+    bool start;
+
+    core_util_critical_section_enter();
+    start = !transferActive && queueDepth > 0;
+    if ( start ) {
+        transferActive = true;
+    }
+    core_util_critical_section_exit();
+
+    if ( start ) {
+        i2cBus->transferStart( &queue[queueHead] );
+    }
+}
@@ -0,0 +1,68 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _I2C_SCHEDULER_H_
+#define _I2C_SCHEDULER_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+#define I2C_SCHEDULER_QUEUE_SIZE    8
+
+//=====[Declaration of public data types]======================================
+
+typedef enum {
+    I2C_TRANSFER_OK,
+    I2C_TRANSFER_ERROR
+} i2cTransferResult_t;
+
+// @note The callback runs in interrupt context when the bus backend completes
+// transfers by interrupt, so it must only copy data and set flags.
+typedef void (*i2cTransferCallback_t)( void * context,
+                                       i2cTransferResult_t result );
+
+// @note A write of txLength bytes followed, if rxLength is not zero, by a
+// read of rxLength bytes after a repeated start. The address is the 8-bit
+// (shifted) address used by mbed. The buffers must stay valid until the
+// callback is called.
+typedef struct {
+    uint8_t address;
+    const uint8_t * txData;
+    int txLength;
+    uint8_t * rxData;
+    int rxLength;
+    i2cTransferCallback_t callback;
+    void * context;
+} i2cTransaction_t;
+
+// @note Bus backend: starts a transfer without blocking and later reports its
+// end through i2cSchedulerTransferComplete(). transferStart() is only called
+// from task context.
+typedef struct {
+    void (*init)();
+    void (*transferStart)( const i2cTransaction_t * transaction );
+} i2cBus_t;
+
+typedef struct {
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t errors;
+    uint32_t rejected;
+    int maxQueueDepth;
+} i2cSchedulerStats_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void i2cSchedulerInit( const i2cBus_t * bus );
+bool i2cSchedulerSubmit( const i2cTransaction_t * transaction );
+void i2cSchedulerUpdate();
+void i2cSchedulerTransferComplete( i2cTransferResult_t result );
+
+int i2cSchedulerQueueDepth();
+void i2cSchedulerStatsGet( i2cSchedulerStats_t * stats );
+
+//=====[#include guards - end]=================================================
+
+#endif // _I2C_SCHEDULER_H_
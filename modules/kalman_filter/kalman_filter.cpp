@@ -0,0 +1,110 @@
+//=====[Libraries]=============================================================
+
+#include "kalman_filter.h"
+
+#include <math.h>
+
+//=====[Declaration of private defines]========================================
+
+#define Q16_ONE                         65536
+#define Q16_LIMIT                       ( (int64_t)Q16_ONE * \
+                                          KALMAN_FILTER_MEASUREMENT_MAX )
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static int32_t saturate( int64_t value );
+
+//=====[Implementations of public functions]===================================
+
+// @note processNoise is the standard deviation of the random acceleration
+// (measurement units per second squared) and measurementNoise that of the
+// measurements (measurement units). A larger processNoise / measurementNoise
+// ratio follows changes sooner and filters less noise.
+void kalmanFilterInit( kalmanFilter_t * filter, float processNoise,
+                       float measurementNoise, int periodMs )
+{
+    filter->value = 0;
+    filter->rate = 0;
+    filter->processNoise = processNoise;
+    filter->measurementNoise = measurementNoise;
+    filter->initialized = false;
+    kalmanFilterPeriodSet( filter, periodMs );
+}
+
+// @note Steady-state gains from the tracking index, as given by Kalata
+// (1984). Uses floating point, so it is meant for initialization and
+// occasional changes of the sampling period, not for every sample.
+void kalmanFilterPeriodSet( kalmanFilter_t * filter, int periodMs )
+{
+    float period = periodMs / 1000.0f;
+    float trackingIndex = filter->processNoise * period * period /
+                          filter->measurementNoise;
+    float r = ( 4.0f + trackingIndex -
+                sqrtf( 8.0f * trackingIndex + trackingIndex * trackingIndex ) ) /
+              4.0f;
+    float alpha = 1.0f - r * r;
+    float beta = 2.0f * ( 2.0f - alpha ) - 4.0f * sqrtf( 1.0f - alpha );
+
+    filter->alpha = (int32_t)( alpha * Q16_ONE );
+    filter->betaOverPeriod = (int32_t)( beta / period * Q16_ONE );
+    filter->period = (int32_t)( period * Q16_ONE );
+}
+
+// @note The first measurement initializes the value, with a zero rate.
+// Measurements beyond KALMAN_FILTER_MEASUREMENT_MAX in magnitude, which the
+// Q16.16 value cannot hold, are clamped to it. The intermediate results are
+// 64-bit and the state saturates at the same limit, so a reading out of
+// range, such as that of an open LM35 input, never wraps the estimate.
+void kalmanFilterUpdate( kalmanFilter_t * filter, int32_t measurement )
+{
+    int64_t measured;
+    int64_t predicted;
+    int64_t residual;
+
+    if ( measurement > KALMAN_FILTER_MEASUREMENT_MAX ) {
+        measurement = KALMAN_FILTER_MEASUREMENT_MAX;
+    } else if ( measurement < -KALMAN_FILTER_MEASUREMENT_MAX ) {
+        measurement = -KALMAN_FILTER_MEASUREMENT_MAX;
+    }
+    measured = (int64_t)measurement * Q16_ONE;
+
+    if ( !filter->initialized ) {
+        filter->value = (int32_t)measured;
+        filter->rate = 0;
+        filter->initialized = true;
+        return;
+    }
+
+    predicted = filter->value +
+                ( ( (int64_t)filter->rate * filter->period ) >> 16 );
+    residual = measured - predicted;
+    filter->value = saturate( predicted +
+                              ( ( filter->alpha * residual ) >> 16 ) );
+    filter->rate = saturate( filter->rate +
+                             ( ( filter->betaOverPeriod * residual ) >> 16 ) );
+}
+
+int32_t kalmanFilterValue( const kalmanFilter_t * filter )
+{
+    return ( filter->value + Q16_ONE / 2 ) >> 16;
+}
+
+int32_t kalmanFilterRate( const kalmanFilter_t * filter )
+{
+    return ( filter->rate + Q16_ONE / 2 ) >> 16;
+}
+
+//=====[Implementations of private functions]==================================
+
+// @note Value and rate are both kept within the measurement range, which
+// leaves room for the rounding of kalmanFilterValue() and kalmanFilterRate().
+static int32_t saturate( int64_t value )
+{
+    if ( value > Q16_LIMIT ) {
+        return (int32_t)Q16_LIMIT;
+    }
+    if ( value < -Q16_LIMIT ) {
+        return (int32_t)-Q16_LIMIT;
+    }
+    return (int32_t)value;
+}
@@ -0,0 +1,45 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _KALMAN_FILTER_H_
+#define _KALMAN_FILTER_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+#define KALMAN_FILTER_MEASUREMENT_MAX   32767
+
+//=====[Declaration of public data types]======================================
+
+// @note Two-state (value and rate) Kalman filter of a constant-velocity
+// model, run with its steady-state gains: with constant noise and sampling
+// period the gains of the full filter converge to the alpha and beta of an
+// alpha-beta tracker, so only they are kept and each sample costs a few
+// integer operations. The state is in Q16.16 fixed point, in the units of
+// the measurements (and those units per second for the rate).
+typedef struct {
+    int32_t value;
+    int32_t rate;
+    int32_t alpha;
+    int32_t betaOverPeriod;
+    int32_t period;
+    float processNoise;
+    float measurementNoise;
+    bool initialized;
+} kalmanFilter_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void kalmanFilterInit( kalmanFilter_t * filter, float processNoise,
+                       float measurementNoise, int periodMs );
+void kalmanFilterPeriodSet( kalmanFilter_t * filter, int periodMs );
+void kalmanFilterUpdate( kalmanFilter_t * filter, int32_t measurement );
+
+int32_t kalmanFilterValue( const kalmanFilter_t * filter );
+int32_t kalmanFilterRate( const kalmanFilter_t * filter );
+
+//=====[#include guards - end]=================================================
+
+#endif // _KALMAN_FILTER_H_
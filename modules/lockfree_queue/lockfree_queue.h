@@ -0,0 +1,175 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _LOCKFREE_QUEUE_H_
+#define _LOCKFREE_QUEUE_H_
+
+//=====[Libraries]=============================================================
+
+#include <atomic>
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+// @note Bounded queues passing data from interrupt handlers (or threads) to
+// the task that consumes it, without masking interrupts or taking a mutex.
+// The capacity must be a power of two so that the free-running 32-bit
+// indices wrap around consistently; every slot is usable.
+//
+// SpscQueue: one producer and one consumer, e.g. the UART RX interrupt and
+// uartTask().
+// MpscQueue: any number of producers, e.g. several interrupt handlers, and
+// one consumer.
+//
+// The head and tail indices live in separate cache lines so that a producer
+// and a consumer on different cores do not invalidate each other's line.
+
+#ifndef LOCKFREE_QUEUE_CACHE_LINE
+#define LOCKFREE_QUEUE_CACHE_LINE   32
+#endif
+
+static_assert( ATOMIC_INT_LOCK_FREE == 2,
+               "the lock-free queues need lock-free 32-bit atomics" );
+
+//=====[Declaration of public classes]=========================================
+
+template <typename T, uint32_t Capacity>
+class SpscQueue {
+    static_assert( Capacity >= 2 && ( Capacity & ( Capacity - 1 ) ) == 0,
+                   "the queue capacity must be a power of two" );
+
+public:
+    SpscQueue() : head( 0 ), tail( 0 ) {}
+
+    // Producer side only. Returns false if the queue is full.
+    bool push( const T & item )
+    {
+        uint32_t position = head.load( std::memory_order_relaxed );
+
+        if ( position - tail.load( std::memory_order_acquire ) == Capacity ) {
+            return false;
+        }
+        buffer[position & ( Capacity - 1 )] = item;
+        head.store( position + 1, std::memory_order_release );
+        return true;
+    }
+
+    // Consumer side only. Returns false if the queue is empty.
+    bool pop( T & item )
+    {
+        uint32_t position = tail.load( std::memory_order_relaxed );
+
+        if ( position == head.load( std::memory_order_acquire ) ) {
+            return false;
+        }
+        item = buffer[position & ( Capacity - 1 )];
+        tail.store( position + 1, std::memory_order_release );
+        return true;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    uint32_t size() const
+    {
+        return head.load( std::memory_order_acquire ) -
+               tail.load( std::memory_order_acquire );
+    }
+
+private:
+    alignas( LOCKFREE_QUEUE_CACHE_LINE ) std::atomic<uint32_t> head;
+    alignas( LOCKFREE_QUEUE_CACHE_LINE ) std::atomic<uint32_t> tail;
+    alignas( LOCKFREE_QUEUE_CACHE_LINE ) T buffer[Capacity];
+};
+
+// @note Bounded queue of D. Vyukov: every slot carries a sequence number
+// telling whether it is free for the producer of a given round or holds an
+// item for the consumer. Producers claim slots with a compare-and-swap on the
+// head; a producer interrupted between claiming and filling its slot only
+// delays the consumer, which sees the queue as empty until then.
+template <typename T, uint32_t Capacity>
+class MpscQueue {
+    static_assert( Capacity >= 2 && ( Capacity & ( Capacity - 1 ) ) == 0,
+                   "the queue capacity must be a power of two" );
+
+public:
+    MpscQueue() : head( 0 ), tail( 0 )
+    {
+        uint32_t i;
+
+        for ( i = 0; i < Capacity; i++ ) {
+            cells[i].sequence.store( i, std::memory_order_relaxed );
+        }
+    }
+
+    // Any producer. Returns false if the queue is full.
+    bool push( const T & item )
+    {
+        uint32_t position = head.load( std::memory_order_relaxed );
+        cell_t * cell;
+        int32_t difference;
+
+        while ( true ) {
+            cell = &cells[position & ( Capacity - 1 )];
+            difference = (int32_t)(
+                cell->sequence.load( std::memory_order_acquire ) - position );
+            if ( difference == 0 ) {
+                if ( head.compare_exchange_weak(
+                         position, position + 1,
+                         std::memory_order_relaxed ) ) {
+                    break;
+                }
+            } else if ( difference < 0 ) {
+                return false;
+            } else {
+                position = head.load( std::memory_order_relaxed );
+            }
+        }
+        cell->item = item;
+        cell->sequence.store( position + 1, std::memory_order_release );
+        return true;
+    }
+
+    // Consumer side only. Returns false if the queue is empty.
+    bool pop( T & item )
+    {
+        uint32_t position = tail.load( std::memory_order_relaxed );
+        cell_t * cell = &cells[position & ( Capacity - 1 )];
+
+        if ( (int32_t)( cell->sequence.load( std::memory_order_acquire ) -
+                        ( position + 1 ) ) < 0 ) {
+            return false;
+        }
+        item = cell->item;
+        cell->sequence.store( position + Capacity, std::memory_order_release );
+        tail.store( position + 1, std::memory_order_relaxed );
+        return true;
+    }
+
+    // Approximate while producers are pushing.
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    uint32_t size() const
+    {
+        return head.load( std::memory_order_acquire ) -
+               tail.load( std::memory_order_acquire );
+    }
+
+private:
+    typedef struct {
+        std::atomic<uint32_t> sequence;
+        T item;
+    } cell_t;
+
+    alignas( LOCKFREE_QUEUE_CACHE_LINE ) std::atomic<uint32_t> head;
+    alignas( LOCKFREE_QUEUE_CACHE_LINE ) std::atomic<uint32_t> tail;
+    alignas( LOCKFREE_QUEUE_CACHE_LINE ) cell_t cells[Capacity];
+};
+
+//=====[#include guards - end]=================================================
+
+#endif // _LOCKFREE_QUEUE_H_
@@ -0,0 +1,136 @@
+//=====[Libraries]=============================================================
+
+#include "mbed.h"
+
+#include "matrix_keypad.h"
+#include "lockfree_queue.h"
+#include "trace.h"
+
+//=====[Declaration and initialization of private global objects]==============
+
+// @note Rows are driven low one at a time; columns read low on the keys of
+// that row being pressed. The second column is on PF_13 (D7) rather than
+// PB_13, which the NUCLEO-F429ZI routes to the Ethernet PHY as RMII_TXD1:
+// a key there would corrupt the frames sent by the network modules. None of
+// the pins is shared with the RMII, USB or ST-LINK signals of the board.
+static DigitalOut keypadRowPins[MATRIX_KEYPAD_ROWS] = {
+    DigitalOut( PB_3, 1 ), DigitalOut( PB_5, 1 ),
+    DigitalOut( PC_7, 1 ), DigitalOut( PA_15, 1 ),
+};
+static DigitalIn keypadColPins[MATRIX_KEYPAD_COLS] = {
+    DigitalIn( PB_12, PullUp ), DigitalIn( PF_13, PullUp ),
+    DigitalIn( PB_15, PullUp ), DigitalIn( PC_6, PullUp ),
+};
+
+static Ticker keypadScanTicker;
+
+//=====[Declaration and initialization of private global variables]============
+
+static const char keypadKeys[MATRIX_KEYPAD_ROWS][MATRIX_KEYPAD_COLS] = {
+    { '1', '2', '3', 'A' },
+    { '4', '5', '6', 'B' },
+    { '7', '8', '9', 'C' },
+    { '*', '0', '#', 'D' },
+};
+
+// @note Per-key debouncing: a key changes state only after it has read the
+// same for MATRIX_KEYPAD_DEBOUNCE_SCANS scans in a row. Every key is
+// tracked on its own, so any number of keys can be down at once; without a
+// diode per key, though, three keys at the corners of a rectangle make the
+// fourth read as pressed too.
+static uint8_t keyCounters[MATRIX_KEYPAD_ROWS][MATRIX_KEYPAD_COLS];
+static volatile uint16_t keysPressed = 0;
+static int scannedRow = 0;
+
+static SpscQueue<matrixKeypadEvent_t, MATRIX_KEYPAD_EVENT_QUEUE_SIZE> keypadEvents;
+static volatile uint32_t eventsLost = 0;
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static void keypadScan();
+
+//=====[Implementations of public functions]===================================
+
+void matrixKeypadInit()
+{
+    int row;
+
+    for ( row = 0; row < MATRIX_KEYPAD_ROWS; row++ ) {
+        keypadRowPins[row] = 1;
+    }
+    scannedRow = 0;
+    keypadRowPins[scannedRow] = 0;
+    keypadScanTicker.attach( keypadScan, std::chrono::microseconds(
+                                 MATRIX_KEYPAD_SCAN_PERIOD_US ) );
+}
+
+// @note Called from the control loop, the only consumer of the events.
+bool matrixKeypadEventRead( matrixKeypadEvent_t * event )
+{
+    return keypadEvents.pop( *event );
+}
+
+bool matrixKeypadIsPressed( char key )
+{
+    int row;
+    int col;
+
+    for ( row = 0; row < MATRIX_KEYPAD_ROWS; row++ ) {
+        for ( col = 0; col < MATRIX_KEYPAD_COLS; col++ ) {
+            if ( keypadKeys[row][col] == key ) {
+                return keysPressed & ( 1 << ( row * MATRIX_KEYPAD_COLS + col ) );
+            }
+        }
+    }
+    return false;
+}
+
+uint32_t matrixKeypadEventsLost()
+{
+    return eventsLost;
+}
+
+//=====[Implementations of private functions]==================================
+
+// @note Ticker interrupt. Each call reads the columns of the row driven low
+// by the previous call, a whole scan period ago, so the lines have settled
+// without any wait, and then drives the next row. A call only reads four
+// pins, so it takes a few microseconds; the whole keypad is scanned every
+// MATRIX_KEYPAD_ROWS periods.
+static void keypadScan()
+{
+    matrixKeypadEvent_t event;
+    uint16_t keyMask;
+    bool pressed;
+    bool wasPressed;
+    int col;
+
+    traceBegin( TRACE_EVENT_KEYPAD_SCAN_ISR );
+    for ( col = 0; col < MATRIX_KEYPAD_COLS; col++ ) {
+        keyMask = 1 << ( scannedRow * MATRIX_KEYPAD_COLS + col );
+        pressed = ( keypadColPins[col] == 0 );
+        wasPressed = ( keysPressed & keyMask ) != 0;
+
+        if ( pressed == wasPressed ) {
+            keyCounters[scannedRow][col] = 0;
+            continue;
+        }
+        keyCounters[scannedRow][col]++;
+        if ( keyCounters[scannedRow][col] < MATRIX_KEYPAD_DEBOUNCE_SCANS ) {
+            continue;
+        }
+
+        keyCounters[scannedRow][col] = 0;
+        keysPressed ^= keyMask;
+        event.key = keypadKeys[scannedRow][col];
+        event.pressed = pressed;
+        if ( !keypadEvents.push( event ) ) {
+            eventsLost++;
+        }
+    }
+
+    keypadRowPins[scannedRow] = 1;
+    scannedRow = ( scannedRow + 1 ) % MATRIX_KEYPAD_ROWS;
+    keypadRowPins[scannedRow] = 0;
+    traceEnd( TRACE_EVENT_KEYPAD_SCAN_ISR );
+}
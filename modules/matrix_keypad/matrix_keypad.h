@@ -0,0 +1,34 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _MATRIX_KEYPAD_H_
+#define _MATRIX_KEYPAD_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+#define MATRIX_KEYPAD_ROWS                  4
+#define MATRIX_KEYPAD_COLS                  4
+#define MATRIX_KEYPAD_SCAN_PERIOD_US     1000
+#define MATRIX_KEYPAD_DEBOUNCE_SCANS        5
+#define MATRIX_KEYPAD_EVENT_QUEUE_SIZE     16
+
+//=====[Declaration of public data types]======================================
+
+typedef struct {
+    char key;
+    bool pressed;
+} matrixKeypadEvent_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void matrixKeypadInit();
+bool matrixKeypadEventRead( matrixKeypadEvent_t * event );
+bool matrixKeypadIsPressed( char key );
+uint32_t matrixKeypadEventsLost();
+
+//=====[#include guards - end]=================================================
+
+#endif // _MATRIX_KEYPAD_H_
@@ -0,0 +1,142 @@
+//=====[Libraries]=============================================================
+
+#include "moving_average.h"
+
+//=====[Declaration of private defines]========================================
+
+// The running sum must hold a full window of full-scale samples.
+static_assert( (uint64_t)MOVING_AVERAGE_MAX_SAMPLES * MOVING_AVERAGE_FULL_SCALE
+               <= UINT32_MAX, "moving average sum would overflow" );
+
+//=====[Implementations of public functions]===================================
+
+void movingAverageInit( movingAverage_t * filter, int numberOfSamples )
+{
+    int i;
+
+    if ( numberOfSamples > MOVING_AVERAGE_MAX_SAMPLES ) {
+        numberOfSamples = MOVING_AVERAGE_MAX_SAMPLES;
+    }
+    if ( numberOfSamples < 1 ) {
+        numberOfSamples = 1;
+    }
+
+    for ( i = 0; i < MOVING_AVERAGE_MAX_SAMPLES; i++ ) {
+        filter->samples[i] = 0;
+    }
+    filter->sum = 0;
+    filter->sumOfSquares = 0;
+    filter->index = 0;
+    filter->numberOfSamples = numberOfSamples;
+    filter->samplesTaken = 0;
+}
+
+void movingAverageUpdate( movingAverage_t * filter, uint16_t sample )
+{
+    uint16_t oldestSample = filter->samples[filter->index];
+
+    filter->sum = filter->sum - oldestSample + sample;
+    filter->sumOfSquares = filter->sumOfSquares
+                         - (uint32_t)oldestSample * oldestSample
+                         + (uint32_t)sample * sample;
+    filter->samples[filter->index] = sample;
+    filter->index++;
+    if ( filter->index >= filter->numberOfSamples ) {
+        filter->index = 0;
+    }
+    if ( filter->samplesTaken < filter->numberOfSamples ) {
+        filter->samplesTaken++;
+    }
+}
+
+// @note Fills the whole window with one sample, typically the first reading,
+// so the average starts there instead of ramping up from zero. It counts as
+// a single real sample: the filter is only full once the window holds
+// numberOfSamples of them.
+void movingAverageFill( movingAverage_t * filter, uint16_t sample )
+{
+    int i;
+
+    for ( i = 0; i < filter->numberOfSamples; i++ ) {
+        filter->samples[i] = sample;
+    }
+    filter->sum = (uint32_t)sample * filter->numberOfSamples;
+    filter->sumOfSquares = (uint64_t)sample * sample * filter->numberOfSamples;
+    filter->index = 0;
+    filter->samplesTaken = 1;
+}
+
+uint16_t movingAverageRead( const movingAverage_t * filter )
+{
+    return ( filter->sum + filter->numberOfSamples / 2 ) / filter->numberOfSamples;
+}
+
+// @note Same scale as AnalogIn::read(), 0.0 to 1.0, without rounding the
+// average to whole counts first.
+float movingAverageReadNormalized( const movingAverage_t * filter )
+{
+    return (float)filter->sum /
+           ( (float)filter->numberOfSamples * MOVING_AVERAGE_FULL_SCALE );
+}
+
+uint16_t movingAverageLastSample( const movingAverage_t * filter )
+{
+    int lastIndex = filter->index - 1;
+
+    if ( lastIndex < 0 ) {
+        lastIndex = filter->numberOfSamples - 1;
+    }
+    return filter->samples[lastIndex];
+}
+
+// @note Population variance of the window in counts^2, obtained from the
+// running sums as ( N * sum(x^2) - sum(x)^2 ) / N^2.
+uint32_t movingAverageVariance( const movingAverage_t * filter )
+{
+    uint64_t numberOfSamples = filter->numberOfSamples;
+    uint64_t numerator = numberOfSamples * filter->sumOfSquares -
+                         (uint64_t)filter->sum * filter->sum;
+
+    return numerator / ( numberOfSamples * numberOfSamples );
+}
+
+// @note Changes the window length keeping the latest samples. When the window
+// grows, the missing samples are filled with the mean of the kept ones, so the
+// average does not jump; the filter only counts as full again once it holds
+// that many real samples.
+void movingAverageWindowSet( movingAverage_t * filter, int numberOfSamples )
+{
+    uint16_t latestSamples[MOVING_AVERAGE_MAX_SAMPLES];
+    uint32_t sum = 0;
+    uint16_t mean = 0;
+    int samplesKept;
+    int i;
+
+    samplesKept = filter->samplesTaken;
+    if ( samplesKept > numberOfSamples ) {
+        samplesKept = numberOfSamples;
+    }
+    for ( i = 0; i < samplesKept; i++ ) {
+        latestSamples[samplesKept - 1 - i] =
+            filter->samples[( filter->index - 1 - i + filter->numberOfSamples ) %
+                            filter->numberOfSamples];
+        sum += latestSamples[samplesKept - 1 - i];
+    }
+    if ( samplesKept > 0 ) {
+        mean = ( sum + samplesKept / 2 ) / samplesKept;
+    }
+
+    movingAverageInit( filter, numberOfSamples );
+    for ( i = samplesKept; i < filter->numberOfSamples; i++ ) {
+        movingAverageUpdate( filter, mean );
+    }
+    for ( i = 0; i < samplesKept; i++ ) {
+        movingAverageUpdate( filter, latestSamples[i] );
+    }
+    filter->samplesTaken = samplesKept;
+}
+
+bool movingAverageIsFull( const movingAverage_t * filter )
+{
+    return filter->samplesTaken >= filter->numberOfSamples;
+}
@@ -0,0 +1,44 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _MOVING_AVERAGE_H_
+#define _MOVING_AVERAGE_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+#define MOVING_AVERAGE_MAX_SAMPLES      100
+#define MOVING_AVERAGE_FULL_SCALE       65535
+
+//=====[Declaration of public data types]======================================
+
+// @note Boxcar average over raw AnalogIn::read_u16() counts. The sums are
+// kept up to date by subtracting the sample that leaves the window and adding
+// the new one, so an update costs the same whatever the window length is.
+typedef struct {
+    uint16_t samples[MOVING_AVERAGE_MAX_SAMPLES];
+    uint32_t sum;
+    uint64_t sumOfSquares;
+    int index;
+    int numberOfSamples;
+    int samplesTaken;
+} movingAverage_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void movingAverageInit( movingAverage_t * filter, int numberOfSamples );
+void movingAverageUpdate( movingAverage_t * filter, uint16_t sample );
+void movingAverageFill( movingAverage_t * filter, uint16_t sample );
+void movingAverageWindowSet( movingAverage_t * filter, int numberOfSamples );
+
+uint16_t movingAverageRead( const movingAverage_t * filter );
+float movingAverageReadNormalized( const movingAverage_t * filter );
+uint16_t movingAverageLastSample( const movingAverage_t * filter );
+uint32_t movingAverageVariance( const movingAverage_t * filter );
+bool movingAverageIsFull( const movingAverage_t * filter );
+
+//=====[#include guards - end]=================================================
+
+#endif // _MOVING_AVERAGE_H_
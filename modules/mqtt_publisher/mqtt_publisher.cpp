@@ -0,0 +1,578 @@
+//=====[Libraries]=============================================================
+
+#include "mbed.h"
+
+#include "mqtt_publisher.h"
+
+#if MBED_CONF_APP_MQTT_ENABLED
+
+#include "network.h"
+#include "object_pool.h"
+#include "timer_wheel.h"
+
+//=====[Declaration of private defines]========================================
+
+#define MQTT_TX_BUFFER_SIZE         ( MQTT_PUBLISHER_PAYLOAD_SIZE + 64 )
+#define MQTT_RX_BUFFER_SIZE         16
+#define MQTT_TOPIC_SIZE             48
+#define MQTT_RETRY_TIME             5000
+#define MQTT_KEEPALIVE_S            60
+
+#define MQTT_PACKET_CONNECT         0x10
+#define MQTT_PACKET_CONNACK         0x20
+#define MQTT_PACKET_PUBLISH         0x30
+#define MQTT_PACKET_PUBACK          0x40
+#define MQTT_PACKET_PINGREQ         0xC0
+#define MQTT_PACKET_PINGRESP        0xD0
+#define MQTT_PUBLISH_DUP            0x08
+#define MQTT_PUBLISH_QOS1           0x02
+#define MQTT_CONNECT_CLEAN_SESSION  0x02
+
+// Worst case of a readings payload: the header plus 7 characters per reading.
+static_assert( 40 + 7 * MQTT_PUBLISHER_BATCH_SIZE <= MQTT_PUBLISHER_PAYLOAD_SIZE,
+               "MQTT readings batch does not fit the payload" );
+
+//=====[Declaration of private data types]=====================================
+
+typedef enum {
+    MQTT_TOPIC_ALARM,
+    MQTT_TOPIC_TEMPERATURE
+} mqttTopic_t;
+
+typedef enum {
+    MQTT_DISCONNECTED,
+    MQTT_TCP_CONNECTING,
+    MQTT_WAITING_CONNACK,
+    MQTT_CONNECTED
+} mqttState_t;
+
+typedef struct {
+    mqttTopic_t topic;
+    uint8_t qos;
+    uint16_t packetId;
+    bool sent;
+    uint32_t sentTimeMs;
+    int length;
+    char payload[MQTT_PUBLISHER_PAYLOAD_SIZE];
+} mqttMessage_t;
+
+//=====[Declaration and initialization of private global objects]==============
+
+static TCPSocket socket;
+static SocketAddress brokerAddress;
+
+//=====[Declaration and initialization of private global variables]============
+
+// @note Outgoing messages wait here while the link is down. The messages
+// come from a fixed pool, so an outage costs no memory beyond it; when it is
+// exhausted, temperature batches are dropped before alarm events.
+static ObjectPool<mqttMessage_t, MQTT_PUBLISHER_QUEUE_SIZE> messagePool;
+static mqttMessage_t * queue[MQTT_PUBLISHER_QUEUE_SIZE];
+static int queueHead = 0;
+static int queueCount = 0;
+
+static mqttState_t mqttState = MQTT_DISCONNECTED;
+static uint32_t stateTimeMs = 0;
+static uint32_t lastTxTimeMs = 0;
+static uint16_t nextPacketId = 1;
+static mqttPublisherStats_t mqttStats;
+
+static uint8_t txBuffer[MQTT_TX_BUFFER_SIZE];
+static int txLength = 0;
+static int txOffset = 0;
+static uint8_t rxBuffer[MQTT_RX_BUFFER_SIZE];
+static int rxLength = 0;
+
+static int16_t readingsBatch[MQTT_PUBLISHER_BATCH_SIZE];
+static int readingsInBatch = 0;
+static uint32_t readingsBatchTimeMs = 0;
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static uint32_t nowMs();
+static void mqttDisconnect();
+static bool mqttConnectionUpdate();
+static bool mqttTransmit();
+static bool mqttReceive();
+static void mqttPacketProcess( const uint8_t * packet, int length );
+static void mqttQueueServe();
+
+static bool messageEnqueue( mqttTopic_t topic, uint8_t qos,
+                            const char * payload, int length );
+static void messageRemove( int position );
+static mqttMessage_t * messageAt( int position );
+
+static int remainingLengthPut( uint8_t * buffer, int length );
+static int stringPut( uint8_t * buffer, const char * string, int length );
+static void packetFinish( uint8_t packetType, int bodyLength );
+static void connectPacketBuild();
+static void publishPacketBuild( const mqttMessage_t * message, bool duplicate );
+static void pingPacketBuild();
+
+//=====[Implementations of public functions]===================================
+
+void mqttPublisherInit()
+{
+    brokerAddress.set_ip_address( MBED_CONF_APP_MQTT_BROKER_HOST );
+    brokerAddress.set_port( MBED_CONF_APP_MQTT_BROKER_PORT );
+    memset( &mqttStats, 0, sizeof( mqttStats ) );
+    while ( queueCount > 0 ) {
+        messageRemove( 0 );
+    }
+    readingsInBatch = 0;
+    mqttState = MQTT_DISCONNECTED;
+    stateTimeMs = nowMs() - MQTT_RETRY_TIME;
+}
+
+// @note Called once per control loop tick. The socket is non-blocking: a
+// packet that cannot be sent at once stays in txBuffer and is completed on
+// the following ticks, and nothing else is sent meanwhile.
+void mqttPublisherUpdate()
+{
+    if ( !mqttConnectionUpdate() ) {
+        return;
+    }
+    if ( !mqttTransmit() || !mqttReceive() ) {
+        mqttDisconnect();
+        return;
+    }
+    if ( mqttState == MQTT_CONNECTED && txOffset >= txLength ) {
+        mqttQueueServe();
+        if ( txOffset >= txLength &&
+             nowMs() - lastTxTimeMs >= MQTT_KEEPALIVE_S * 1000 / 2 ) {
+            pingPacketBuild();
+        }
+        if ( !mqttTransmit() ) {
+            mqttDisconnect();
+        }
+    }
+}
+
+// @note Alarm events are published with QoS 1: they stay queued, and are
+// sent again, until the broker acknowledges them with a PUBACK.
+bool mqttPublisherAlarmEventPublish( const char * payload )
+{
+    return messageEnqueue( MQTT_TOPIC_ALARM, 1, payload, strlen( payload ) );
+}
+
+// @note Readings are batched, MQTT_PUBLISHER_BATCH_SIZE per QoS 0 message,
+// as {"ms":<time of the first reading>,"c":[<hundredths of degree>,...]}.
+void mqttPublisherReadingAdd( uint32_t timeMs, int16_t tempCentiC )
+{
+    char payload[MQTT_PUBLISHER_PAYLOAD_SIZE];
+    int length;
+    int i;
+
+    if ( readingsInBatch == 0 ) {
+        readingsBatchTimeMs = timeMs;
+    }
+    readingsBatch[readingsInBatch] = tempCentiC;
+    readingsInBatch++;
+    if ( readingsInBatch < MQTT_PUBLISHER_BATCH_SIZE ) {
+        return;
+    }
+
+    length = sprintf( payload, "{\"ms\":%lu,\"c\":[",
+                      (unsigned long)readingsBatchTimeMs );
+    for ( i = 0; i < readingsInBatch; i++ ) {
+        length += sprintf( payload + length, i == 0 ? "%d" : ",%d",
+                           readingsBatch[i] );
+    }
+    length += sprintf( payload + length, "]}" );
+    readingsInBatch = 0;
+
+    messageEnqueue( MQTT_TOPIC_TEMPERATURE, 0, payload, length );
+}
+
+bool mqttPublisherIsConnected()
+{
+    return mqttState == MQTT_CONNECTED;
+}
+
+void mqttPublisherStatsGet( mqttPublisherStats_t * stats )
+{
+    *stats = mqttStats;
+    stats->queued = queueCount;
+}
+
+//=====[Implementations of private functions]==================================
+
+static uint32_t nowMs()
+{
+    return timerWheelTicks() * TIMER_WHEEL_TICK_MS;
+}
+
+static void mqttDisconnect()
+{
+    int i;
+
+    if ( mqttState != MQTT_DISCONNECTED ) {
+        socket.close();
+    }
+    mqttState = MQTT_DISCONNECTED;
+    stateTimeMs = nowMs();
+    txLength = 0;
+    txOffset = 0;
+    rxLength = 0;
+    for ( i = 0; i < queueCount; i++ ) {
+        messageAt( i )->sent = false;
+    }
+}
+
+// @note Returns true while a socket is open, that is, once the TCP connection
+// has been started. The connection is retried every MQTT_RETRY_TIME; a
+// socket that cannot be opened or connected leaves its error in
+// mqttStats.socketError.
+static bool mqttConnectionUpdate()
+{
+    nsapi_error_t error;
+
+    if ( !networkIsUp() ) {
+        if ( mqttState != MQTT_DISCONNECTED ) {
+            mqttDisconnect();
+        }
+        return false;
+    }
+
+    switch ( mqttState ) {
+    case MQTT_DISCONNECTED:
+        if ( nowMs() - stateTimeMs < MQTT_RETRY_TIME ) {
+            return false;
+        }
+        stateTimeMs = nowMs();
+        error = socket.open( networkInterface() );
+        if ( error != NSAPI_ERROR_OK ) {
+            mqttStats.socketError = error;
+            return false;
+        }
+        socket.set_blocking( false );
+        mqttState = MQTT_TCP_CONNECTING;
+        // Falls through - the connection is started at once.
+
+    case MQTT_TCP_CONNECTING:
+        error = socket.connect( brokerAddress );
+        if ( error == NSAPI_ERROR_OK || error == NSAPI_ERROR_IS_CONNECTED ) {
+            mqttStats.socketError = NSAPI_ERROR_OK;
+            connectPacketBuild();
+            mqttState = MQTT_WAITING_CONNACK;
+            stateTimeMs = nowMs();
+        } else if ( error != NSAPI_ERROR_IN_PROGRESS &&
+                    error != NSAPI_ERROR_ALREADY &&
+                    error != NSAPI_ERROR_WOULD_BLOCK ) {
+            mqttStats.socketError = error;
+            mqttDisconnect();
+            return false;
+        } else if ( nowMs() - stateTimeMs > MQTT_RETRY_TIME ) {
+            mqttStats.socketError = NSAPI_ERROR_CONNECTION_TIMEOUT;
+            mqttDisconnect();
+            return false;
+        }
+        break;
+
+    case MQTT_WAITING_CONNACK:
+        if ( nowMs() - stateTimeMs > MQTT_RETRY_TIME ) {
+            mqttDisconnect();
+            return false;
+        }
+        break;
+
+    case MQTT_CONNECTED:
+        break;
+    }
+    return mqttState != MQTT_TCP_CONNECTING;
+}
+
+static bool mqttTransmit()
+{
+    nsapi_size_or_error_t sent;
+
+    if ( txOffset >= txLength ) {
+        return true;
+    }
+    sent = socket.send( txBuffer + txOffset, txLength - txOffset );
+    if ( sent == NSAPI_ERROR_WOULD_BLOCK ) {
+        return true;
+    }
+    if ( sent < 0 ) {
+        return false;
+    }
+    txOffset += sent;
+    lastTxTimeMs = nowMs();
+    return true;
+}
+
+// @note The broker only sends short packets to a publisher (CONNACK, PUBACK
+// and PINGRESP), so a small buffer holding at least one whole packet is
+// enough.
+static bool mqttReceive()
+{
+    nsapi_size_or_error_t received;
+    int packetLength;
+
+    received = socket.recv( rxBuffer + rxLength, sizeof( rxBuffer ) - rxLength );
+    if ( received == NSAPI_ERROR_WOULD_BLOCK ) {
+        return true;
+    }
+    if ( received <= 0 ) {
+        return false;
+    }
+    rxLength += received;
+
+    while ( rxLength >= 2 ) {
+        if ( rxBuffer[1] & 0x80 ) {
+            return false;
+        }
+        packetLength = 2 + rxBuffer[1];
+        if ( packetLength > (int)sizeof( rxBuffer ) ) {
+            return false;
+        }
+        if ( rxLength < packetLength ) {
+            break;
+        }
+        mqttPacketProcess( rxBuffer, packetLength );
+        rxLength -= packetLength;
+        memmove( rxBuffer, rxBuffer + packetLength, rxLength );
+    }
+    return true;
+}
+
+static void mqttPacketProcess( const uint8_t * packet, int length )
+{
+    mqttMessage_t * head;
+    uint16_t packetId;
+
+    switch ( packet[0] & 0xF0 ) {
+    case MQTT_PACKET_CONNACK:
+        if ( length == 4 && packet[3] == 0 ) {
+            mqttState = MQTT_CONNECTED;
+        }
+        break;
+
+    case MQTT_PACKET_PUBACK:
+        if ( length != 4 || queueCount == 0 ) {
+            break;
+        }
+        packetId = ( packet[2] << 8 ) | packet[3];
+        head = messageAt( 0 );
+        if ( head->sent && head->qos == 1 && head->packetId == packetId ) {
+            messageRemove( 0 );
+            mqttStats.acknowledged++;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+// @note Messages go out in order with at most one QoS 1 message in flight;
+// batching keeps the message rate low enough for that.
+static void mqttQueueServe()
+{
+    mqttMessage_t * head;
+
+    if ( queueCount == 0 ) {
+        return;
+    }
+    head = messageAt( 0 );
+
+    if ( !head->sent ) {
+        publishPacketBuild( head, false );
+        mqttStats.published++;
+        if ( head->qos == 0 ) {
+            messageRemove( 0 );
+        } else {
+            head->sent = true;
+            head->sentTimeMs = nowMs();
+        }
+    } else if ( nowMs() - head->sentTimeMs > MQTT_RETRY_TIME ) {
+        publishPacketBuild( head, true );
+        mqttStats.retransmitted++;
+        head->sentTimeMs = nowMs();
+    }
+}
+
+static bool messageEnqueue( mqttTopic_t topic, uint8_t qos,
+                            const char * payload, int length )
+{
+    mqttMessage_t * message;
+    int i;
+
+    if ( length > MQTT_PUBLISHER_PAYLOAD_SIZE ) {
+        return false;
+    }
+
+    if ( queueCount >= MQTT_PUBLISHER_QUEUE_SIZE ) {
+        for ( i = 0; i < queueCount && messageAt( i )->qos != 0; i++ ) {
+        }
+        if ( i < queueCount ) {
+            messageRemove( i );
+        } else if ( qos == 0 ) {
+            mqttStats.dropped++;
+            return false;
+        } else {
+            messageRemove( messageAt( 0 )->sent ? 1 : 0 );
+            mqttStats.alarmEventsDropped++;
+        }
+        mqttStats.dropped++;
+    }
+
+    message = messagePool.alloc();
+    if ( message == NULL ) {
+        mqttStats.dropped++;
+        if ( qos > 0 ) {
+            mqttStats.alarmEventsDropped++;
+        }
+        return false;
+    }
+    queue[( queueHead + queueCount ) % MQTT_PUBLISHER_QUEUE_SIZE] = message;
+    queueCount++;
+    message->topic = topic;
+    message->qos = qos;
+    message->packetId = 0;
+    if ( qos > 0 ) {
+        message->packetId = nextPacketId++;
+        if ( nextPacketId == 0 ) {
+            nextPacketId = 1;
+        }
+    }
+    message->sent = false;
+    message->length = length;
+    memcpy( message->payload, payload, length );
+    return true;
+}
+
+static void messageRemove( int position )
+{
+    int i;
+
+    messagePool.free( messageAt( position ) );
+    if ( position == 0 ) {
+        queueHead = ( queueHead + 1 ) % MQTT_PUBLISHER_QUEUE_SIZE;
+    } else {
+        for ( i = position; i < queueCount - 1; i++ ) {
+            queue[( queueHead + i ) % MQTT_PUBLISHER_QUEUE_SIZE] =
+                queue[( queueHead + i + 1 ) % MQTT_PUBLISHER_QUEUE_SIZE];
+        }
+    }
+    queueCount--;
+}
+
+static mqttMessage_t * messageAt( int position )
+{
+    return queue[( queueHead + position ) % MQTT_PUBLISHER_QUEUE_SIZE];
+}
+
+static int remainingLengthPut( uint8_t * buffer, int length )
+{
+    int bytes = 0;
+
+    do {
+        buffer[bytes] = length % 128;
+        length = length / 128;
+        if ( length > 0 ) {
+            buffer[bytes] |= 0x80;
+        }
+        bytes++;
+    } while ( length > 0 );
+    return bytes;
+}
+
+static int stringPut( uint8_t * buffer, const char * string, int length )
+{
+    buffer[0] = length >> 8;
+    buffer[1] = length & 0xFF;
+    memcpy( buffer + 2, string, length );
+    return length + 2;
+}
+
+// @note Variable header and payload are written after a 5-byte gap, the
+// largest fixed header, and the fixed header is then placed right before
+// them; this avoids a second buffer.
+static void packetFinish( uint8_t packetType, int bodyLength )
+{
+    uint8_t fixedHeader[5];
+    int headerLength;
+
+    fixedHeader[0] = packetType;
+    headerLength = 1 + remainingLengthPut( fixedHeader + 1, bodyLength );
+    txOffset = 5 - headerLength;
+    memcpy( txBuffer + txOffset, fixedHeader, headerLength );
+    txLength = 5 + bodyLength;
+}
+
+static void connectPacketBuild()
+{
+    uint8_t * body = txBuffer + 5;
+    int length = 0;
+
+    length += stringPut( body + length, "MQTT", 4 );
+    body[length++] = 4;
+    body[length++] = MQTT_CONNECT_CLEAN_SESSION;
+    body[length++] = MQTT_KEEPALIVE_S >> 8;
+    body[length++] = MQTT_KEEPALIVE_S & 0xFF;
+    length += stringPut( body + length, MBED_CONF_APP_MQTT_CLIENT_ID,
+                         strlen( MBED_CONF_APP_MQTT_CLIENT_ID ) );
+    packetFinish( MQTT_PACKET_CONNECT, length );
+}
+
+static void publishPacketBuild( const mqttMessage_t * message, bool duplicate )
+{
+    uint8_t * body = txBuffer + 5;
+    char topic[MQTT_TOPIC_SIZE];
+    uint8_t packetType = MQTT_PACKET_PUBLISH;
+    int length = 0;
+
+    snprintf( topic, sizeof( topic ), "%s/%s", MBED_CONF_APP_MQTT_TOPIC_PREFIX,
+              message->topic == MQTT_TOPIC_ALARM ? "alarm" : "temperature" );
+    length += stringPut( body + length, topic, strlen( topic ) );
+    if ( message->qos > 0 ) {
+        packetType |= MQTT_PUBLISH_QOS1;
+        body[length++] = message->packetId >> 8;
+        body[length++] = message->packetId & 0xFF;
+    }
+    if ( duplicate ) {
+        packetType |= MQTT_PUBLISH_DUP;
+    }
+    memcpy( body + length, message->payload, message->length );
+    length += message->length;
+    packetFinish( packetType, length );
+}
+
+static void pingPacketBuild()
+{
+    packetFinish( MQTT_PACKET_PINGREQ, 0 );
+}
+
+#else
+
+//=====[Implementations of public functions]===================================
+
+void mqttPublisherInit()
+{
+}
+
+void mqttPublisherUpdate()
+{
+}
+
+bool mqttPublisherAlarmEventPublish( const char * payload )
+{
+    return false;
+}
+
+void mqttPublisherReadingAdd( uint32_t timeMs, int16_t tempCentiC )
+{
+}
+
+bool mqttPublisherIsConnected()
+{
+    return false;
+}
+
+void mqttPublisherStatsGet( mqttPublisherStats_t * stats )
+{
+    memset( stats, 0, sizeof( *stats ) );
+}
+
+#endif // MBED_CONF_APP_MQTT_ENABLED
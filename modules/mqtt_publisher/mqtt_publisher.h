@@ -0,0 +1,45 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _MQTT_PUBLISHER_H_
+#define _MQTT_PUBLISHER_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+#define MQTT_PUBLISHER_QUEUE_SIZE       8
+#define MQTT_PUBLISHER_PAYLOAD_SIZE     128
+#define MQTT_PUBLISHER_BATCH_SIZE       10
+
+//=====[Declaration of public data types]======================================
+
+// @note dropped counts every message lost with the queue full;
+// alarmEventsDropped the QoS 1 alarm events among them, which only happens
+// when the queue holds nothing but alarm events. socketError is the last
+// error of the socket open or connection, NSAPI_ERROR_OK once connected.
+typedef struct {
+    uint32_t published;
+    uint32_t acknowledged;
+    uint32_t retransmitted;
+    uint32_t dropped;
+    uint32_t alarmEventsDropped;
+    int socketError;
+    int queued;
+} mqttPublisherStats_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void mqttPublisherInit();
+void mqttPublisherUpdate();
+
+bool mqttPublisherAlarmEventPublish( const char * payload );
+void mqttPublisherReadingAdd( uint32_t timeMs, int16_t tempCentiC );
+
+bool mqttPublisherIsConnected();
+void mqttPublisherStatsGet( mqttPublisherStats_t * stats );
+
+//=====[#include guards - end]=================================================
+
+#endif // _MQTT_PUBLISHER_H_
@@ -0,0 +1,89 @@
+//=====[Libraries]=============================================================
+
+#include "mbed.h"
+
+#include "network.h"
+
+#if NETWORK_ENABLED
+
+#include "timer_wheel.h"
+
+//=====[Declaration and initialization of private global objects]==============
+
+static EthernetInterface net;
+
+//=====[Declaration and initialization of private global variables]============
+
+static timerWheelTimer_t connectRetryTimer;
+static bool connectRetryDue = true;
+static bool connecting = false;
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static void connectRetryTimerExpired( void * context );
+
+//=====[Implementations of public functions]===================================
+
+void networkInit()
+{
+    net.set_blocking( false );
+    connectRetryDue = true;
+    connecting = false;
+    timerWheelStart( &connectRetryTimer, NETWORK_CONNECT_RETRY_TIME,
+                     NETWORK_CONNECT_RETRY_TIME, connectRetryTimerExpired,
+                     NULL );
+}
+
+// @note The interface is used in non-blocking mode, so neither a missing
+// cable nor a missing DHCP server stalls the control loop. While the
+// interface is down, the connection is retried every
+// NETWORK_CONNECT_RETRY_TIME.
+void networkUpdate()
+{
+    nsapi_connection_status_t status = net.get_connection_status();
+
+    if ( status == NSAPI_STATUS_DISCONNECTED ) {
+        connecting = false;
+    }
+    if ( !connecting && connectRetryDue ) {
+        connectRetryDue = false;
+        net.connect();
+        connecting = true;
+    }
+}
+
+bool networkIsUp()
+{
+    return net.get_connection_status() == NSAPI_STATUS_GLOBAL_UP;
+}
+
+NetworkInterface * networkInterface()
+{
+    return &net;
+}
+
+//=====[Implementations of private functions]==================================
+
+static void connectRetryTimerExpired( void * context )
+{
+    connectRetryDue = true;
+}
+
+#else
+
+//=====[Implementations of public functions]===================================
+
+void networkInit()
+{
+}
+
+void networkUpdate()
+{
+}
+
+bool networkIsUp()
+{
+    return false;
+}
+
+#endif // NETWORK_ENABLED
@@ -0,0 +1,33 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _NETWORK_H_
+#define _NETWORK_H_
+
+//=====[Libraries]=============================================================
+
+#include "mbed.h"
+
+//=====[Declaration of public defines]=========================================
+
+#define NETWORK_ENABLED \
+    ( MBED_CONF_APP_UDP_ENABLED || MBED_CONF_APP_MQTT_ENABLED )
+
+#define NETWORK_CONNECT_RETRY_TIME      5000
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+#if NETWORK_ENABLED
+
+#include "EthernetInterface.h"
+
+NetworkInterface * networkInterface();
+
+#endif
+
+void networkInit();
+void networkUpdate();
+bool networkIsUp();
+
+//=====[#include guards - end]=================================================
+
+#endif // _NETWORK_H_
@@ -0,0 +1,121 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _OBJECT_POOL_H_
+#define _OBJECT_POOL_H_
+
+//=====[Libraries]=============================================================
+
+#include <atomic>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+//=====[Declaration of public data types]======================================
+
+typedef struct {
+    uint16_t capacity;
+    uint16_t used;
+    uint16_t peak;
+    uint32_t failures;
+} objectPoolStats_t;
+
+//=====[Declaration of public classes]=========================================
+
+// @note Fixed number of blocks for objects of type T, sized at compile time
+// and allocated statically, so there is no heap use and both alloc() and
+// free() take constant time. The free blocks form a lock-free stack, so
+// objects can be allocated and released from interrupt handlers as well as
+// from tasks. The head of the stack holds a block index and a tag that
+// changes on every update, which prevents the ABA problem of a plain
+// compare-and-swap.
+template <typename T, uint16_t Count>
+class ObjectPool {
+    static_assert( Count > 0 && Count < 0xFFFF, "invalid object pool size" );
+
+public:
+    ObjectPool() : freeHead( 0 ), used( 0 ), peak( 0 ), failures( 0 )
+    {
+        uint16_t i;
+
+        for ( i = 0; i < Count; i++ ) {
+            next[i].store( i + 1 < Count ? i + 1 : NO_BLOCK,
+                           std::memory_order_relaxed );
+        }
+    }
+
+    // Returns NULL when every block is in use.
+    template <typename... Args>
+    T * alloc( Args &&... args )
+    {
+        uint32_t head = freeHead.load( std::memory_order_acquire );
+        uint32_t newHead;
+        uint16_t index;
+        uint16_t inUse;
+        uint16_t peakSeen;
+
+        do {
+            index = head & 0xFFFF;
+            if ( index == NO_BLOCK ) {
+                failures.fetch_add( 1, std::memory_order_relaxed );
+                return NULL;
+            }
+            newHead = tagged( head, next[index].load( std::memory_order_relaxed ) );
+        } while ( !freeHead.compare_exchange_weak( head, newHead,
+                                                   std::memory_order_acquire,
+                                                   std::memory_order_acquire ) );
+
+        inUse = used.fetch_add( 1, std::memory_order_relaxed ) + 1;
+        peakSeen = peak.load( std::memory_order_relaxed );
+        while ( inUse > peakSeen &&
+                !peak.compare_exchange_weak( peakSeen, inUse,
+                                             std::memory_order_relaxed ) ) {
+        }
+        return new ( &blocks[index] ) T( std::forward<Args>( args )... );
+    }
+
+    void free( T * object )
+    {
+        uint16_t index = reinterpret_cast<block_t *>( object ) - blocks;
+        uint32_t head = freeHead.load( std::memory_order_relaxed );
+
+        object->~T();
+        do {
+            next[index].store( head & 0xFFFF, std::memory_order_relaxed );
+        } while ( !freeHead.compare_exchange_weak( head, tagged( head, index ),
+                                                   std::memory_order_release,
+                                                   std::memory_order_relaxed ) );
+        used.fetch_sub( 1, std::memory_order_relaxed );
+    }
+
+    void statsGet( objectPoolStats_t * stats ) const
+    {
+        stats->capacity = Count;
+        stats->used = used.load( std::memory_order_relaxed );
+        stats->peak = peak.load( std::memory_order_relaxed );
+        stats->failures = failures.load( std::memory_order_relaxed );
+    }
+
+private:
+    static const uint16_t NO_BLOCK = 0xFFFF;
+
+    typedef struct {
+        alignas( T ) uint8_t storage[sizeof( T )];
+    } block_t;
+
+    static uint32_t tagged( uint32_t head, uint16_t index )
+    {
+        return ( ( ( head >> 16 ) + 1 ) << 16 ) | index;
+    }
+
+    block_t blocks[Count];
+    std::atomic<uint16_t> next[Count];
+    std::atomic<uint32_t> freeHead;
+    std::atomic<uint16_t> used;
+    std::atomic<uint16_t> peak;
+    std::atomic<uint32_t> failures;
+};
+
+//=====[#include guards - end]=================================================
+
+#endif // _OBJECT_POOL_H_
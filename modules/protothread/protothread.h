@@ -0,0 +1,60 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _PROTOTHREAD_H_
+#define _PROTOTHREAD_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+// @note Stackless cooperative threads in the style of Adam Dunkels'
+// protothreads. A protothread is a function that returns whenever it has to
+// wait and resumes at the same line on its next call, so it can be written as
+// straight sequential code while the superloop keeps running. The only state
+// kept between calls is the line number stored in protothread_t; any variable
+// that must survive a wait has to be static or global.
+//
+// Restriction: no switch statement may enclose a PT_WAIT_UNTIL() or
+// PT_YIELD() inside the protothread body, since the macros expand to case
+// labels of the switch opened by PT_BEGIN().
+
+#define PT_INIT( pt )       ( (pt)->line = 0 )
+
+#define PT_BEGIN( pt )      switch ( (pt)->line ) { case 0:
+
+#define PT_WAIT_UNTIL( pt, condition )                  \
+    do {                                                \
+        (pt)->line = __LINE__;                          \
+        case __LINE__:                                  \
+        if ( !( condition ) ) {                         \
+            return PT_WAITING;                          \
+        }                                               \
+    } while ( 0 )
+
+#define PT_YIELD( pt )                                  \
+    do {                                                \
+        (pt)->line = __LINE__;                          \
+        return PT_WAITING;                              \
+        case __LINE__:;                                 \
+    } while ( 0 )
+
+#define PT_END( pt )        } PT_INIT( pt ); return PT_ENDED
+
+//=====[Declaration of public data types]======================================
+
+typedef enum {
+    PT_WAITING,
+    PT_ENDED
+} protothreadStatus_t;
+
+typedef struct {
+    uint16_t line;
+} protothread_t;
+
+typedef protothreadStatus_t (*protothreadFunction_t)( protothread_t * pt );
+
+//=====[#include guards - end]=================================================
+
+#endif // _PROTOTHREAD_H_
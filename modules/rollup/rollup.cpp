@@ -0,0 +1,175 @@
+//=====[Libraries]=============================================================
+
+#include "rollup.h"
+
+#include <stddef.h>
+
+//=====[Declaration of private defines]========================================
+
+#define ROLLUP_SECONDS                  60
+#define ROLLUP_MINUTES                  60
+#define ROLLUP_HOURS                    24
+
+//=====[Declaration of private data types]=====================================
+
+typedef struct {
+    uint32_t resolutionMs;
+    int length;
+    rollupBucket_t * buckets;
+    int newest;
+    int used;
+    rollupBucket_t open;
+} rollupLevel_t;
+
+//=====[Declaration and initialization of private global variables]============
+
+static rollupBucket_t secondBuckets[ROLLUP_SECONDS];
+static rollupBucket_t minuteBuckets[ROLLUP_MINUTES];
+static rollupBucket_t hourBuckets[ROLLUP_HOURS];
+
+// @note Finest resolution first. Each level is fed by the buckets the level
+// before it closes, never by raw samples.
+static rollupLevel_t levels[ROLLUP_LEVELS] = {
+    { 1000, ROLLUP_SECONDS, secondBuckets },
+    { 60000, ROLLUP_MINUTES, minuteBuckets },
+    { 3600000, ROLLUP_HOURS, hourBuckets },
+};
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static void levelAdvance( int level, uint32_t timeMs );
+static void bucketMerge( rollupBucket_t * bucket, const rollupBucket_t * other );
+
+//=====[Implementations of public functions]===================================
+
+void rollupInit()
+{
+    int i;
+
+    for ( i = 0; i < ROLLUP_LEVELS; i++ ) {
+        levels[i].newest = 0;
+        levels[i].used = 0;
+        levels[i].open.count = 0;
+    }
+}
+
+// @note Constant time per sample except at the end of a second, when the
+// closed bucket is merged into the minute (and at the end of a minute into
+// the hour). A bucket holds only the samples that were added, so a gap in
+// the samples leaves a gap in the buckets.
+void rollupAdd( uint32_t timeMs, int32_t value )
+{
+    rollupBucket_t sample;
+
+    sample.min = value;
+    sample.max = value;
+    sample.sum = value;
+    sample.count = 1;
+
+    levelAdvance( 0, timeMs );
+    bucketMerge( &levels[0].open, &sample );
+}
+
+void rollupCursorInit( rollupCursor_t * cursor, int level )
+{
+    cursor->level = level;
+    cursor->nextStartTimeMs = 0;
+    cursor->started = false;
+    cursor->done = false;
+}
+
+// @note Calls the visitor for at most maxBuckets buckets of the level from
+// the cursor on: the closed buckets, oldest first, then the bucket still
+// being filled, if it has any sample, which ends the walk. Returns whether
+// the cursor has buckets left. A bucket being filled does not include yet
+// the samples of the finer bucket being filled. Start times are compared as
+// differences, which holds across the wrap of the millisecond time.
+bool rollupForEachNext( rollupCursor_t * cursor, int maxBuckets,
+                        rollupVisitor_t visitor, void * context )
+{
+    rollupLevel_t * rollupLevel = &levels[cursor->level];
+    rollupBucket_t * bucket;
+    int i;
+
+    if ( cursor->done ) {
+        return false;
+    }
+    for ( i = rollupLevel->used - 1; i >= 0 && maxBuckets > 0; i-- ) {
+        bucket = &rollupLevel->buckets[( rollupLevel->newest - i +
+                                         rollupLevel->length ) %
+                                       rollupLevel->length];
+        if ( cursor->started &&
+             (int32_t)( bucket->startTimeMs - cursor->nextStartTimeMs ) < 0 ) {
+            continue;
+        }
+        visitor( bucket, true, context );
+        cursor->nextStartTimeMs = bucket->startTimeMs +
+                                  rollupLevel->resolutionMs;
+        cursor->started = true;
+        maxBuckets--;
+    }
+    if ( maxBuckets > 0 ) {
+        if ( rollupLevel->open.count > 0 ) {
+            visitor( &rollupLevel->open, false, context );
+        }
+        cursor->done = true;
+    }
+    return !cursor->done;
+}
+
+uint32_t rollupResolutionMs( int level )
+{
+    return levels[level].resolutionMs;
+}
+
+int rollupLength( int level )
+{
+    return levels[level].length;
+}
+
+//=====[Implementations of private functions]==================================
+
+static void levelAdvance( int level, uint32_t timeMs )
+{
+    rollupLevel_t * rollupLevel = &levels[level];
+    uint32_t startTimeMs = timeMs - timeMs % rollupLevel->resolutionMs;
+
+    if ( rollupLevel->open.count > 0 &&
+         rollupLevel->open.startTimeMs != startTimeMs ) {
+        if ( rollupLevel->used > 0 ) {
+            rollupLevel->newest = ( rollupLevel->newest + 1 ) %
+                                  rollupLevel->length;
+        }
+        if ( rollupLevel->used < rollupLevel->length ) {
+            rollupLevel->used++;
+        }
+        rollupLevel->buckets[rollupLevel->newest] = rollupLevel->open;
+
+        if ( level + 1 < ROLLUP_LEVELS ) {
+            levelAdvance( level + 1, rollupLevel->open.startTimeMs );
+            bucketMerge( &levels[level + 1].open, &rollupLevel->open );
+        }
+        rollupLevel->open.count = 0;
+    }
+    if ( rollupLevel->open.count == 0 ) {
+        rollupLevel->open.startTimeMs = startTimeMs;
+    }
+}
+
+static void bucketMerge( rollupBucket_t * bucket, const rollupBucket_t * other )
+{
+    if ( bucket->count == 0 ) {
+        bucket->min = other->min;
+        bucket->max = other->max;
+        bucket->sum = 0;
+    } else {
+        if ( other->min < bucket->min ) {
+            bucket->min = other->min;
+        }
+        if ( other->max > bucket->max ) {
+            bucket->max = other->max;
+        }
+    }
+    bucket->sum += other->sum;
+    bucket->count += other->count;
+}
@@ -0,0 +1,49 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _ROLLUP_H_
+#define _ROLLUP_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+#define ROLLUP_LEVELS                   3
+
+//=====[Declaration of public data types]======================================
+
+typedef struct {
+    uint32_t startTimeMs;
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    uint32_t count;
+} rollupBucket_t;
+
+typedef void (*rollupVisitor_t)( const rollupBucket_t * bucket, bool closed,
+                                  void * context );
+
+// @note Buckets are found by their start time, so a cursor stays valid while
+// buckets close: it only skips those overwritten meanwhile.
+typedef struct {
+    int level;
+    uint32_t nextStartTimeMs;
+    bool started;
+    bool done;
+} rollupCursor_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void rollupInit();
+void rollupAdd( uint32_t timeMs, int32_t value );
+void rollupCursorInit( rollupCursor_t * cursor, int level );
+bool rollupForEachNext( rollupCursor_t * cursor, int maxBuckets,
+                        rollupVisitor_t visitor, void * context );
+
+uint32_t rollupResolutionMs( int level );
+int rollupLength( int level );
+
+//=====[#include guards - end]=================================================
+
+#endif // _ROLLUP_H_
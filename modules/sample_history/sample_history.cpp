@@ -0,0 +1,159 @@
+//=====[Libraries]=============================================================
+
+#include "sample_history.h"
+
+#include "delta_codec.h"
+
+//=====[Declaration of private data types]=====================================
+
+// @note Each block is encoded independently, so the oldest one can be
+// overwritten without decoding or re-encoding the others.
+typedef struct {
+    uint32_t firstTimeMs;
+    uint32_t firstSample;
+    uint16_t samples;
+    uint8_t length;
+    uint8_t data[SAMPLE_HISTORY_BLOCK_SIZE];
+} historyBlock_t;
+
+static_assert( SAMPLE_HISTORY_BLOCK_SIZE <= 255,
+               "history block length must fit in historyBlock_t::length" );
+
+//=====[Declaration and initialization of private global variables]============
+
+static historyBlock_t blocks[SAMPLE_HISTORY_BLOCKS];
+static int newestBlock = 0;
+static int usedBlocks = 0;
+static deltaEncoder_t encoder;
+static uint32_t samplePeriodMs = 0;
+static uint32_t samplesAdded = 0;
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static void blockStart( uint32_t timeMs );
+static historyBlock_t * blockByAge( int age );
+
+//=====[Implementations of public functions]===================================
+
+// @note Samples are expected every periodMs; only the time of the first
+// sample of each block is stored.
+void sampleHistoryInit( uint32_t periodMs )
+{
+    samplePeriodMs = periodMs;
+    newestBlock = 0;
+    usedBlocks = 0;
+    samplesAdded = 0;
+}
+
+void sampleHistoryAdd( uint32_t timeMs, int32_t value )
+{
+    if ( usedBlocks == 0 ) {
+        blockStart( timeMs );
+    }
+    if ( !deltaEncoderAdd( &encoder, value ) ) {
+        blockStart( timeMs );
+        deltaEncoderAdd( &encoder, value );
+    }
+    blocks[newestBlock].samples++;
+    blocks[newestBlock].length = encoder.length;
+    samplesAdded++;
+}
+
+// @note The cursor covers the samples stored when it is set, oldest first;
+// samples added later are left for the next cursor.
+void sampleHistoryCursorInit( sampleHistoryCursor_t * cursor )
+{
+    cursor->next = usedBlocks > 0 ? blockByAge( usedBlocks - 1 )->firstSample :
+                                    samplesAdded;
+    cursor->end = samplesAdded;
+}
+
+// @note Calls the visitor for at most maxSamples samples from the cursor on,
+// oldest first, and returns whether the cursor has samples left. Samples
+// overwritten since the cursor was set are skipped. Only the block holding
+// the cursor is decoded up to it, so a call costs at most one block more
+// than the samples it visits.
+bool sampleHistoryForEachNext( sampleHistoryCursor_t * cursor, int maxSamples,
+                               sampleHistoryVisitor_t visitor, void * context )
+{
+    deltaDecoder_t decoder;
+    historyBlock_t * block;
+    uint32_t sample;
+    uint32_t timeMs;
+    int32_t value;
+    int i;
+
+    for ( i = usedBlocks - 1; i >= 0 && maxSamples > 0; i-- ) {
+        block = blockByAge( i );
+        if ( block->firstSample + block->samples <= cursor->next ) {
+            continue;
+        }
+        if ( block->firstSample >= cursor->end ) {
+            break;
+        }
+        if ( cursor->next < block->firstSample ) {
+            cursor->next = block->firstSample;
+        }
+        sample = block->firstSample;
+        timeMs = block->firstTimeMs;
+        deltaDecoderInit( &decoder, block->data, block->length );
+        while ( maxSamples > 0 && cursor->next < cursor->end &&
+                deltaDecoderNext( &decoder, &value ) ) {
+            if ( sample >= cursor->next ) {
+                visitor( timeMs, value, context );
+                cursor->next++;
+                maxSamples--;
+            }
+            sample++;
+            timeMs += samplePeriodMs;
+        }
+    }
+    return cursor->next < cursor->end;
+}
+
+uint32_t sampleHistorySamples()
+{
+    uint32_t samples = 0;
+    int i;
+
+    for ( i = 0; i < usedBlocks; i++ ) {
+        samples += blockByAge( i )->samples;
+    }
+    return samples;
+}
+
+int sampleHistoryBytes()
+{
+    int bytes = 0;
+    int i;
+
+    for ( i = 0; i < usedBlocks; i++ ) {
+        bytes += blockByAge( i )->length;
+    }
+    return bytes;
+}
+
+//=====[Implementations of private functions]==================================
+
+static void blockStart( uint32_t timeMs )
+{
+    if ( usedBlocks > 0 ) {
+        newestBlock = ( newestBlock + 1 ) % SAMPLE_HISTORY_BLOCKS;
+    }
+    if ( usedBlocks < SAMPLE_HISTORY_BLOCKS ) {
+        usedBlocks++;
+    }
+    blocks[newestBlock].firstTimeMs = timeMs;
+    blocks[newestBlock].firstSample = samplesAdded;
+    blocks[newestBlock].samples = 0;
+    blocks[newestBlock].length = 0;
+    deltaEncoderInit( &encoder, blocks[newestBlock].data,
+                      SAMPLE_HISTORY_BLOCK_SIZE );
+}
+
+// @note Age 0 is the newest block.
+static historyBlock_t * blockByAge( int age )
+{
+    return &blocks[( newestBlock - age + SAMPLE_HISTORY_BLOCKS ) %
+                   SAMPLE_HISTORY_BLOCKS];
+}
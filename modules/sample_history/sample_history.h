@@ -0,0 +1,40 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _SAMPLE_HISTORY_H_
+#define _SAMPLE_HISTORY_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+#define SAMPLE_HISTORY_BLOCKS           16
+#define SAMPLE_HISTORY_BLOCK_SIZE       64
+
+//=====[Declaration of public data types]======================================
+
+typedef void (*sampleHistoryVisitor_t)( uint32_t timeMs, int32_t value,
+                                        void * context );
+
+// @note Samples are numbered in the order they are added, so a cursor stays
+// valid while samples are added: it only skips those overwritten meanwhile.
+typedef struct {
+    uint32_t next;
+    uint32_t end;
+} sampleHistoryCursor_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void sampleHistoryInit( uint32_t periodMs );
+void sampleHistoryAdd( uint32_t timeMs, int32_t value );
+void sampleHistoryCursorInit( sampleHistoryCursor_t * cursor );
+bool sampleHistoryForEachNext( sampleHistoryCursor_t * cursor, int maxSamples,
+                               sampleHistoryVisitor_t visitor, void * context );
+
+uint32_t sampleHistorySamples();
+int sampleHistoryBytes();
+
+//=====[#include guards - end]=================================================
+
+#endif // _SAMPLE_HISTORY_H_
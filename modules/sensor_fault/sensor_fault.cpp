@@ -0,0 +1,75 @@
+//=====[Libraries]=============================================================
+
+#include "sensor_fault.h"
+
+//=====[Implementations of public functions]===================================
+
+// @note Meant to run on every sample: the latest sample catches an open or
+// shorted input at once, and the average keeps the fault raised until the
+// whole window is plausible again.
+uint8_t analogSensorRangeCheck( const movingAverage_t * filter,
+                                const analogSensorLimits_t * limits )
+{
+    uint16_t lastSample = movingAverageLastSample( filter );
+    uint16_t average = movingAverageRead( filter );
+
+    if ( lastSample < limits->minCounts || lastSample > limits->maxCounts ) {
+        return SENSOR_FAULT_OUT_OF_RANGE;
+    }
+    if ( movingAverageIsFull( filter ) &&
+         ( average < limits->minCounts || average > limits->maxCounts ) ) {
+        return SENSOR_FAULT_OUT_OF_RANGE;
+    }
+    return SENSOR_FAULT_NONE;
+}
+
+// @note Meant to run periodically. A live analog input always shows some ADC
+// noise, so a window with (almost) no variance means a stuck converter or
+// sensor; a stuckVariance of 0 disables this check for sensors that can
+// legitimately repeat the same value. The change of the average since the
+// previous call is compared against the largest change the physical
+// quantity can have in that time.
+uint8_t analogSensorTrendCheck( const movingAverage_t * filter,
+                                const analogSensorLimits_t * limits,
+                                uint16_t previousAverage )
+{
+    uint8_t faults = SENSOR_FAULT_NONE;
+    uint16_t average = movingAverageRead( filter );
+    int change = (int)average - (int)previousAverage;
+
+    if ( !movingAverageIsFull( filter ) ) {
+        return SENSOR_FAULT_NONE;
+    }
+    if ( limits->stuckVariance > 0 &&
+         movingAverageVariance( filter ) <= limits->stuckVariance ) {
+        faults |= SENSOR_FAULT_STUCK;
+    }
+    if ( change > limits->maxChangeCounts ||
+         -change > limits->maxChangeCounts ) {
+        faults |= SENSOR_FAULT_RATE;
+    }
+    return faults;
+}
+
+const char * sensorFaultDescription( uint8_t faults )
+{
+    if ( faults & SENSOR_FAULT_NO_VALID_SENSOR ) {
+        return "no valid sensor left";
+    }
+    if ( faults & SENSOR_FAULT_OPEN ) {
+        return "open input";
+    }
+    if ( faults & SENSOR_FAULT_OUT_OF_RANGE ) {
+        return "out of range";
+    }
+    if ( faults & SENSOR_FAULT_STUCK ) {
+        return "stuck value";
+    }
+    if ( faults & SENSOR_FAULT_RATE ) {
+        return "implausible rate of change";
+    }
+    if ( faults & SENSOR_FAULT_DISAGREEMENT ) {
+        return "redundant sensors disagree";
+    }
+    return "none";
+}
@@ -0,0 +1,46 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _SENSOR_FAULT_H_
+#define _SENSOR_FAULT_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+#include "moving_average.h"
+
+//=====[Declaration of public defines]=========================================
+
+// Fault flags, several of them can be raised at the same time.
+#define SENSOR_FAULT_NONE             0x00
+#define SENSOR_FAULT_OUT_OF_RANGE     0x01
+#define SENSOR_FAULT_STUCK            0x02
+#define SENSOR_FAULT_RATE             0x04
+#define SENSOR_FAULT_OPEN             0x08
+#define SENSOR_FAULT_DISAGREEMENT     0x10
+#define SENSOR_FAULT_NO_VALID_SENSOR  0x20
+
+//=====[Declaration of public data types]======================================
+
+// @note All the limits are in raw read_u16() counts, so the checks never
+// convert to engineering units.
+typedef struct {
+    uint16_t minCounts;
+    uint16_t maxCounts;
+    uint32_t stuckVariance;
+    uint16_t maxChangeCounts;
+} analogSensorLimits_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+uint8_t analogSensorRangeCheck( const movingAverage_t * filter,
+                                const analogSensorLimits_t * limits );
+uint8_t analogSensorTrendCheck( const movingAverage_t * filter,
+                                const analogSensorLimits_t * limits,
+                                uint16_t previousAverage );
+
+const char * sensorFaultDescription( uint8_t faults );
+
+//=====[#include guards - end]=================================================
+
+#endif // _SENSOR_FAULT_H_
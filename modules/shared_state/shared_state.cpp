@@ -0,0 +1,88 @@
+//=====[Libraries]=============================================================
+
+#include "shared_state.h"
+
+#include <atomic>
+#include <string.h>
+
+//=====[Declaration of private data types]=====================================
+
+// @note The sequence number and the state share one 32-byte block, the
+// cache line size of the Cortex-M7 parts, so a reader touches a single line.
+typedef struct alignas( 32 ) {
+    std::atomic<uint32_t> sequence;
+    statusReport_t state;
+} sharedStateBlock_t;
+
+//=====[Declaration and initialization of private global variables]============
+
+static sharedStateBlock_t sharedState;
+static std::atomic<uint32_t> readRetries( 0 );
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static bool sharedStateReadAttempt( statusReport_t * state );
+
+//=====[Implementations of public functions]===================================
+
+// @note Seqlock writer: the sequence number is odd while the state is being
+// copied. There must be a single writer, the control loop; it never waits
+// for the readers.
+void sharedStatePublish( const statusReport_t * state )
+{
+    uint32_t sequence = sharedState.sequence.load( std::memory_order_relaxed );
+
+    sharedState.sequence.store( sequence + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    memcpy( &sharedState.state, state, sizeof( *state ) );
+    std::atomic_thread_fence( std::memory_order_release );
+    sharedState.sequence.store( sequence + 2, std::memory_order_relaxed );
+}
+
+// @note Retries until it gets a copy that no publication overlapped. It must
+// not be called from a context that can interrupt the writer (an ISR reading
+// while the loop publishes would spin forever); use sharedStateTryRead()
+// there.
+void sharedStateRead( statusReport_t * state )
+{
+    while ( !sharedStateReadAttempt( state ) ) {
+        readRetries++;
+    }
+}
+
+// @note Gives up after SHARED_STATE_TRY_READ_ATTEMPTS, leaving the state
+// undefined, and returns false.
+bool sharedStateTryRead( statusReport_t * state )
+{
+    int i;
+
+    for ( i = 0; i < SHARED_STATE_TRY_READ_ATTEMPTS; i++ ) {
+        if ( sharedStateReadAttempt( state ) ) {
+            return true;
+        }
+        readRetries++;
+    }
+    return false;
+}
+
+uint32_t sharedStateRetries()
+{
+    return readRetries.load( std::memory_order_relaxed );
+}
+
+//=====[Implementations of private functions]==================================
+
+static bool sharedStateReadAttempt( statusReport_t * state )
+{
+    uint32_t sequenceBefore;
+    uint32_t sequenceAfter;
+
+    sequenceBefore = sharedState.sequence.load( std::memory_order_acquire );
+    if ( sequenceBefore & 1 ) {
+        return false;
+    }
+    memcpy( state, &sharedState.state, sizeof( *state ) );
+    std::atomic_thread_fence( std::memory_order_acquire );
+    sequenceAfter = sharedState.sequence.load( std::memory_order_relaxed );
+    return sequenceBefore == sequenceAfter;
+}
@@ -0,0 +1,23 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _SHARED_STATE_H_
+#define _SHARED_STATE_H_
+
+//=====[Libraries]=============================================================
+
+#include "status_report.h"
+
+//=====[Declaration of public defines]=========================================
+
+#define SHARED_STATE_TRY_READ_ATTEMPTS  4
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void sharedStatePublish( const statusReport_t * state );
+void sharedStateRead( statusReport_t * state );
+bool sharedStateTryRead( statusReport_t * state );
+uint32_t sharedStateRetries();
+
+//=====[#include guards - end]=================================================
+
+#endif // _SHARED_STATE_H_
@@ -0,0 +1,224 @@
+//=====[Libraries]=============================================================
+
+#include "simulated_inputs.h"
+
+#include "lockfree_queue.h"
+
+//=====[Declaration of private defines]========================================
+
+#define SIMULATED_KEYS_TO_TYPE_SIZE     16
+
+//=====[Declaration and initialization of private global variables]============
+
+// @note Every random decision comes from this one generator and is taken at
+// a fixed point of the control loop, so a seed replays the same scenario
+// tick for tick.
+static uint32_t seedUsed = 1;
+static uint32_t randomState = 1;
+
+static const char * validCode = "";
+static int validCodeLength = 0;
+
+static uint32_t lastSecond = 0;
+static uint32_t lastTimeMs = 0;
+
+static float ambientTempC = 22.0f;
+static float temperatureC = 22.0f;
+static bool fireActive = false;
+static uint32_t gasEndSecond = 0;
+static bool gasDetected = false;
+
+static char keysToType[SIMULATED_KEYS_TO_TYPE_SIZE];
+static int numberOfKeysToType = 0;
+static int keyBeingTyped = 0;
+static bool keyDown = false;
+static uint32_t nextKeyMs = 0;
+static bool codeEntryScheduled = false;
+
+static SpscQueue<matrixKeypadEvent_t, 8> keyEvents;
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static uint32_t randomNext();
+static uint32_t randomBelow( uint32_t limit );
+static float randomUniform( float min, float max );
+static void simulatedSecondUpdate( uint32_t second, bool alarmOn );
+static void codeEntrySchedule( uint32_t timeMs );
+static void keysTypingUpdate( uint32_t timeMs );
+
+//=====[Implementations of public functions]===================================
+
+void simulatedInputsInit( uint32_t seed, const char * code, int codeLength )
+{
+    seedUsed = seed;
+    randomState = ( seed != 0 ) ? seed : 1;
+    validCode = code;
+    validCodeLength = codeLength;
+    lastSecond = 0;
+    lastTimeMs = 0;
+    ambientTempC = randomUniform( 18.0f, 26.0f );
+    temperatureC = ambientTempC;
+    fireActive = false;
+    gasDetected = false;
+    numberOfKeysToType = 0;
+    keyBeingTyped = 0;
+    keyDown = false;
+    codeEntryScheduled = false;
+}
+
+// @note Called once per tick with the tick time. Temperatures move every
+// tick; the events are drawn once per simulated second.
+void simulatedInputsUpdate( uint32_t timeMs, bool alarmOn )
+{
+    float elapsedS = ( timeMs - lastTimeMs ) / 1000.0f;
+
+    lastTimeMs = timeMs;
+    while ( lastSecond < timeMs / 1000 ) {
+        lastSecond++;
+        simulatedSecondUpdate( lastSecond, alarmOn );
+    }
+
+    if ( fireActive ) {
+        temperatureC += SIMULATED_FIRE_RISE_C_PER_S * elapsedS;
+        if ( temperatureC >= SIMULATED_FIRE_PEAK_TEMP_C ) {
+            fireActive = false;
+        }
+    } else {
+        // Cools down to the ambient with a time constant of 100 s.
+        temperatureC += ( ambientTempC - temperatureC ) * elapsedS / 100.0f;
+    }
+
+    keysTypingUpdate( timeMs );
+}
+
+float simulatedInputsTemperatureGet()
+{
+    return temperatureC;
+}
+
+// @note A sensor reading: the temperature plus uniform noise, enough for the
+// stuck sensor check to see a live sensor.
+float simulatedInputsTemperatureRead()
+{
+    return temperatureC + randomUniform( -SIMULATED_SENSOR_NOISE_C,
+                                         SIMULATED_SENSOR_NOISE_C );
+}
+
+bool simulatedInputsGasDetected()
+{
+    return gasDetected;
+}
+
+bool simulatedInputsKeyRead( matrixKeypadEvent_t * event )
+{
+    return keyEvents.pop( *event );
+}
+
+uint32_t simulatedInputsSeed()
+{
+    return seedUsed;
+}
+
+//=====[Implementations of private functions]==================================
+
+// @note xorshift32: full period over the non-zero states.
+static uint32_t randomNext()
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static uint32_t randomBelow( uint32_t limit )
+{
+    return randomNext() % limit;
+}
+
+static float randomUniform( float min, float max )
+{
+    return min + ( max - min ) * ( randomNext() >> 8 ) / (float)( 1 << 24 );
+}
+
+static void simulatedSecondUpdate( uint32_t second, bool alarmOn )
+{
+    ambientTempC += randomUniform( -0.05f, 0.05f );
+    if ( ambientTempC < SIMULATED_AMBIENT_TEMP_MIN_C ) {
+        ambientTempC = SIMULATED_AMBIENT_TEMP_MIN_C;
+    }
+    if ( ambientTempC > SIMULATED_AMBIENT_TEMP_MAX_C ) {
+        ambientTempC = SIMULATED_AMBIENT_TEMP_MAX_C;
+    }
+
+    if ( !fireActive && randomBelow( SIMULATED_FIRE_MEAN_INTERVAL_S ) == 0 ) {
+        fireActive = true;
+    }
+
+    if ( gasDetected ) {
+        gasDetected = ( second < gasEndSecond );
+    } else if ( randomBelow( SIMULATED_GAS_MEAN_INTERVAL_S ) == 0 ) {
+        gasDetected = true;
+        gasEndSecond = second + SIMULATED_GAS_MIN_DURATION_S +
+                       randomBelow( SIMULATED_GAS_MAX_DURATION_S -
+                                    SIMULATED_GAS_MIN_DURATION_S + 1 );
+    }
+
+    // Somebody comes to switch the alarm off some time after it starts.
+    if ( alarmOn && !codeEntryScheduled && numberOfKeysToType == 0 ) {
+        codeEntrySchedule( second * 1000 );
+    }
+}
+
+// @note Types '*', the code and '#', the code being wrong now and then so
+// that the incorrect code handling and the lockout are exercised too.
+static void codeEntrySchedule( uint32_t timeMs )
+{
+    bool wrongCode = randomBelow( 100 ) < SIMULATED_WRONG_CODE_PERCENT;
+    int i;
+
+    numberOfKeysToType = 0;
+    keysToType[numberOfKeysToType++] = '*';
+    for ( i = 0; i < validCodeLength &&
+                 numberOfKeysToType < SIMULATED_KEYS_TO_TYPE_SIZE - 1; i++ ) {
+        keysToType[numberOfKeysToType++] = validCode[i];
+    }
+    if ( wrongCode && validCodeLength > 0 ) {
+        i = 1 + randomBelow( validCodeLength );
+        keysToType[i] = ( keysToType[i] == '0' ) ? '1' : '0';
+    }
+    keysToType[numberOfKeysToType++] = '#';
+
+    keyBeingTyped = 0;
+    keyDown = false;
+    nextKeyMs = timeMs + 1000 * ( SIMULATED_CODE_MIN_DELAY_S +
+                                  randomBelow( SIMULATED_CODE_MAX_DELAY_S -
+                                               SIMULATED_CODE_MIN_DELAY_S + 1 ) );
+    codeEntryScheduled = true;
+}
+
+static void keysTypingUpdate( uint32_t timeMs )
+{
+    matrixKeypadEvent_t event;
+
+    if ( !codeEntryScheduled || timeMs < nextKeyMs ) {
+        return;
+    }
+
+    event.key = keysToType[keyBeingTyped];
+    event.pressed = !keyDown;
+    keyEvents.push( event );
+
+    if ( !keyDown ) {
+        keyDown = true;
+        nextKeyMs = timeMs + SIMULATED_KEY_PRESS_TIME;
+        return;
+    }
+
+    keyDown = false;
+    nextKeyMs = timeMs + SIMULATED_KEY_INTERVAL_TIME - SIMULATED_KEY_PRESS_TIME;
+    keyBeingTyped++;
+    if ( keyBeingTyped >= numberOfKeysToType ) {
+        numberOfKeysToType = 0;
+        codeEntryScheduled = false;
+    }
+}
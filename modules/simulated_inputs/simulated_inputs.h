@@ -0,0 +1,45 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _SIMULATED_INPUTS_H_
+#define _SIMULATED_INPUTS_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+#include "matrix_keypad.h"
+
+//=====[Declaration of public defines]=========================================
+
+#define SIMULATED_AMBIENT_TEMP_MIN_C        15.0f
+#define SIMULATED_AMBIENT_TEMP_MAX_C        35.0f
+#define SIMULATED_FIRE_PEAK_TEMP_C          70.0f
+#define SIMULATED_FIRE_RISE_C_PER_S          0.5f
+#define SIMULATED_SENSOR_NOISE_C             0.1f
+
+// Mean time between events, in seconds
+#define SIMULATED_FIRE_MEAN_INTERVAL_S    21600
+#define SIMULATED_GAS_MEAN_INTERVAL_S      7200
+
+#define SIMULATED_GAS_MIN_DURATION_S         30
+#define SIMULATED_GAS_MAX_DURATION_S        180
+#define SIMULATED_CODE_MIN_DELAY_S           10
+#define SIMULATED_CODE_MAX_DELAY_S           60
+#define SIMULATED_WRONG_CODE_PERCENT         10
+#define SIMULATED_KEY_PRESS_TIME            100
+#define SIMULATED_KEY_INTERVAL_TIME         300
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void simulatedInputsInit( uint32_t seed, const char * code, int codeLength );
+void simulatedInputsUpdate( uint32_t timeMs, bool alarmOn );
+
+float simulatedInputsTemperatureGet();
+float simulatedInputsTemperatureRead();
+bool simulatedInputsGasDetected();
+bool simulatedInputsKeyRead( matrixKeypadEvent_t * event );
+uint32_t simulatedInputsSeed();
+
+//=====[#include guards - end]=================================================
+
+#endif // _SIMULATED_INPUTS_H_
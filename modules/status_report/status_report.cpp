@@ -0,0 +1,84 @@
+//=====[Libraries]=============================================================
+
+#include "status_report.h"
+
+#include <stdio.h>
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static uint8_t * uint16Put( uint8_t * buffer, uint16_t value );
+static uint8_t * uint32Put( uint8_t * buffer, uint32_t value );
+
+//=====[Implementations of public functions]===================================
+
+// @note Little endian, fixed layout of STATUS_REPORT_ENCODED_SIZE bytes:
+//   0 magic, 1 version, 2 sequence, 4 uptime (ms), 8 flags,
+//   9 incorrect codes, 10 temperature faults, 11 gas faults,
+//   12 LM35 temperature, 14 voted temperature, 16 potentiometer counts,
+//   18 over temperature level, 19 MQTT alarm events dropped (version 2,
+//   reserved before).
+// Returns the number of bytes written, or 0 if the buffer is too small.
+int statusReportEncode( const statusReport_t * report, uint8_t * buffer,
+                        int size )
+{
+    uint8_t * position = buffer;
+
+    if ( size < STATUS_REPORT_ENCODED_SIZE ) {
+        return 0;
+    }
+
+    *position++ = STATUS_REPORT_MAGIC;
+    *position++ = STATUS_REPORT_VERSION;
+    position = uint16Put( position, report->sequence );
+    position = uint32Put( position, report->uptimeMs );
+    *position++ = report->flags;
+    *position++ = report->numberOfIncorrectCodes;
+    *position++ = report->temperatureFaults;
+    *position++ = report->gasFaults;
+    position = uint16Put( position, (uint16_t)report->lm35TempCentiC );
+    position = uint16Put( position, (uint16_t)report->votedTempCentiC );
+    position = uint16Put( position, report->potentiometer );
+    *position++ = (uint8_t)report->overTempLevel;
+    *position++ = report->mqttAlarmEventsDropped;
+
+    return position - buffer;
+}
+
+// @note Same fields as the binary record, as one comma separated line:
+//   ST,sequence,uptime (ms),flags (hex),incorrect codes,temperature faults,
+//   gas faults,LM35 temperature,voted temperature,potentiometer counts,
+//   over temperature level,MQTT alarm events dropped
+// Returns the length of the line, or 0 if the buffer is too small.
+int statusReportFormat( const statusReport_t * report, char * buffer,
+                        int size )
+{
+    int length;
+
+    length = snprintf( buffer, size,
+                       "ST,%u,%lu,%02X,%u,%u,%u,%d,%d,%u,%d,%u\r\n",
+                       report->sequence, (unsigned long)report->uptimeMs,
+                       report->flags, report->numberOfIncorrectCodes,
+                       report->temperatureFaults, report->gasFaults,
+                       report->lm35TempCentiC, report->votedTempCentiC,
+                       report->potentiometer, report->overTempLevel,
+                       report->mqttAlarmEventsDropped );
+    if ( length < 0 || length >= size ) {
+        return 0;
+    }
+    return length;
+}
+
+//=====[Implementations of private functions]==================================
+
+static uint8_t * uint16Put( uint8_t * buffer, uint16_t value )
+{
+    buffer[0] = value & 0xFF;
+    buffer[1] = value >> 8;
+    return buffer + 2;
+}
+
+static uint8_t * uint32Put( uint8_t * buffer, uint32_t value )
+{
+    buffer = uint16Put( buffer, value & 0xFFFF );
+    return uint16Put( buffer, value >> 16 );
+}
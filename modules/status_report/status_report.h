@@ -0,0 +1,54 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _STATUS_REPORT_H_
+#define _STATUS_REPORT_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+#define STATUS_REPORT_MAGIC             0xA5
+#define STATUS_REPORT_VERSION           2
+#define STATUS_REPORT_ENCODED_SIZE      20
+#define STATUS_REPORT_TEXT_SIZE         72
+
+// Bits of statusReport_t::flags
+#define STATUS_FLAG_ALARM               0x01
+#define STATUS_FLAG_GAS_DETECTED        0x02
+#define STATUS_FLAG_OVER_TEMP_DETECTED  0x04
+#define STATUS_FLAG_GAS_ALARM           0x08
+#define STATUS_FLAG_OVER_TEMP_ALARM     0x10
+#define STATUS_FLAG_SYSTEM_BLOCKED      0x20
+#define STATUS_FLAG_INCORRECT_CODE      0x40
+#define STATUS_FLAG_THRESHOLD_TUNING    0x80
+
+//=====[Declaration of public data types]======================================
+
+// @note Whole device state in one record. Temperatures are in hundredths of
+// a degree Celsius.
+typedef struct {
+    uint16_t sequence;
+    uint32_t uptimeMs;
+    uint8_t flags;
+    uint8_t numberOfIncorrectCodes;
+    uint8_t temperatureFaults;
+    uint8_t gasFaults;
+    int16_t lm35TempCentiC;
+    int16_t votedTempCentiC;
+    uint16_t potentiometer;
+    int8_t overTempLevel;
+    uint8_t mqttAlarmEventsDropped;
+} statusReport_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+int statusReportEncode( const statusReport_t * report, uint8_t * buffer,
+                        int size );
+int statusReportFormat( const statusReport_t * report, char * buffer,
+                        int size );
+
+//=====[#include guards - end]=================================================
+
+#endif // _STATUS_REPORT_H_
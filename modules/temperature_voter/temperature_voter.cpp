@@ -0,0 +1,72 @@
+//=====[Libraries]=============================================================
+
+#include "temperature_voter.h"
+
+//=====[Declaration of private defines]========================================
+
+// The median below drops the lowest and the highest channel, which only
+// leaves the middle one or two with up to four channels.
+static_assert( TEMPERATURE_VOTER_MAX_CHANNELS <= 4,
+               "the median needs at most four channels" );
+
+//=====[Implementations of public functions]===================================
+
+// @note M-out-of-N voting: the over temperature decision needs votesRequired
+// valid channels above the level. When faulty channels leave fewer valid
+// channels than that, the vote degrades to all the remaining valid channels,
+// so a single fault never disables the detection; with no valid channel
+// left, there is no over temperature and the caller decides from
+// validChannels what to do about it. Valid channels further
+// apart than tolerance are flagged as a disagreement. The reported
+// temperature is the median of the valid channels (the mean of the middle
+// two when there are two or four). The cost is a handful of comparisons per call.
+void temperatureVote( const temperatureChannel_t * channels,
+                      int numberOfChannels, int votesRequired,
+                      float overTempLevel, float tolerance,
+                      temperatureVote_t * result )
+{
+    float minimum = 0.0;
+    float maximum = 0.0;
+    float sum = 0.0;
+    int i;
+
+    result->validChannels = 0;
+    result->votesForOverTemp = 0;
+
+    for ( i = 0; i < numberOfChannels && i < TEMPERATURE_VOTER_MAX_CHANNELS; i++ ) {
+        if ( !channels[i].valid ) {
+            continue;
+        }
+        if ( result->validChannels == 0 || channels[i].temperature < minimum ) {
+            minimum = channels[i].temperature;
+        }
+        if ( result->validChannels == 0 || channels[i].temperature > maximum ) {
+            maximum = channels[i].temperature;
+        }
+        sum = sum + channels[i].temperature;
+        result->validChannels++;
+        if ( channels[i].temperature > overTempLevel ) {
+            result->votesForOverTemp++;
+        }
+    }
+
+    if ( votesRequired < 1 ) {
+        votesRequired = 1;
+    }
+    if ( votesRequired > result->validChannels ) {
+        votesRequired = result->validChannels;
+    }
+
+    result->overTemp = result->validChannels > 0 &&
+                       result->votesForOverTemp >= votesRequired;
+    result->disagreement = ( maximum - minimum ) > tolerance;
+
+    if ( result->validChannels >= 3 ) {
+        result->temperature = ( sum - minimum - maximum ) /
+                              ( result->validChannels - 2 );
+    } else if ( result->validChannels > 0 ) {
+        result->temperature = sum / result->validChannels;
+    } else {
+        result->temperature = 0.0;
+    }
+}
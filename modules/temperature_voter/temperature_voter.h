@@ -0,0 +1,34 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _TEMPERATURE_VOTER_H_
+#define _TEMPERATURE_VOTER_H_
+
+//=====[Declaration of public defines]=========================================
+
+#define TEMPERATURE_VOTER_MAX_CHANNELS   4
+
+//=====[Declaration of public data types]======================================
+
+typedef struct {
+    float temperature;
+    bool valid;
+} temperatureChannel_t;
+
+typedef struct {
+    bool overTemp;
+    bool disagreement;
+    int validChannels;
+    int votesForOverTemp;
+    float temperature;
+} temperatureVote_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void temperatureVote( const temperatureChannel_t * channels,
+                      int numberOfChannels, int votesRequired,
+                      float overTempLevel, float tolerance,
+                      temperatureVote_t * result );
+
+//=====[#include guards - end]=================================================
+
+#endif // _TEMPERATURE_VOTER_H_
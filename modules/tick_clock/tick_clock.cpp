@@ -0,0 +1,116 @@
+//=====[Libraries]=============================================================
+
+#include "mbed.h"
+
+#include "tick_clock.h"
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static void realClockInit();
+static uint64_t realClockNowMs();
+static void realClockWaitUntil( uint64_t timeMs );
+
+static void virtualClockInit();
+static uint64_t virtualClockNowMs();
+static void virtualClockWaitUntil( uint64_t timeMs );
+
+//=====[Declaration and initialization of public global variables]=============
+
+const tickClockSource_t tickClockReal = {
+    realClockInit, realClockNowMs, realClockWaitUntil
+};
+
+const tickClockSource_t tickClockVirtual = {
+    virtualClockInit, virtualClockNowMs, virtualClockWaitUntil
+};
+
+//=====[Declaration and initialization of private global variables]============
+
+static const tickClockSource_t * clockSource = &tickClockReal;
+static uint64_t nextTickMs = 0;
+static uint32_t tickPeriodMs = 1;
+static uint32_t overruns = 0;
+static uint32_t skippedTicks = 0;
+
+static uint64_t realClockStartMs = 0;
+static uint64_t virtualTimeMs = 0;
+
+//=====[Implementations of public functions]===================================
+
+void tickClockInit( const tickClockSource_t * source, int tickMs )
+{
+    clockSource = source;
+    clockSource->init();
+    tickPeriodMs = tickMs;
+    nextTickMs = clockSource->nowMs() + tickPeriodMs;
+    overruns = 0;
+    skippedTicks = 0;
+}
+
+// @note Waits for the next tick deadline rather than for a whole tick, so
+// the time spent in the loop does not add up and the ticks keep in step with
+// the clock. A loop that overruns its tick runs the next one at once, but
+// the deadlines already missed are skipped rather than run back to back:
+// the tick after it is back on the original schedule.
+void tickClockWait()
+{
+    uint64_t nowMs = clockSource->nowMs();
+
+    if ( nowMs > nextTickMs ) {
+        overruns++;
+        skippedTicks += ( nowMs - nextTickMs ) / tickPeriodMs;
+        nextTickMs += ( nowMs - nextTickMs ) / tickPeriodMs * tickPeriodMs;
+    }
+    clockSource->waitUntil( nextTickMs );
+    nextTickMs += tickPeriodMs;
+}
+
+uint64_t tickClockNowMs()
+{
+    return clockSource->nowMs();
+}
+
+uint32_t tickClockOverruns()
+{
+    return overruns;
+}
+
+uint32_t tickClockSkippedTicks()
+{
+    return skippedTicks;
+}
+
+//=====[Implementations of private functions]==================================
+
+static void realClockInit()
+{
+    realClockStartMs = Kernel::Clock::now().time_since_epoch().count();
+}
+
+static uint64_t realClockNowMs()
+{
+    return Kernel::Clock::now().time_since_epoch().count() - realClockStartMs;
+}
+
+static void realClockWaitUntil( uint64_t timeMs )
+{
+    ThisThread::sleep_until( Kernel::Clock::time_point(
+        Kernel::Clock::duration( realClockStartMs + timeMs ) ) );
+}
+
+static void virtualClockInit()
+{
+    virtualTimeMs = 0;
+}
+
+static uint64_t virtualClockNowMs()
+{
+    return virtualTimeMs;
+}
+
+static void virtualClockWaitUntil( uint64_t timeMs )
+{
+    if ( timeMs > virtualTimeMs ) {
+        virtualTimeMs = timeMs;
+    }
+}
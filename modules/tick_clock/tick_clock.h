@@ -0,0 +1,39 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _TICK_CLOCK_H_
+#define _TICK_CLOCK_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public data types]======================================
+
+// @note Time source of the control loop, in milliseconds since start up.
+// waitUntil() returns once nowMs() has reached the given time.
+typedef struct {
+    void (*init)();
+    uint64_t (*nowMs)();
+    void (*waitUntil)( uint64_t timeMs );
+} tickClockSource_t;
+
+//=====[Declaration of public global variables]================================
+
+// Kernel clock of mbed OS: the loop sleeps until each tick is due.
+extern const tickClockSource_t tickClockReal;
+
+// Virtual time: waiting only moves the time forward, so the loop runs as
+// fast as the CPU allows and every tick sees the same time on every run.
+extern const tickClockSource_t tickClockVirtual;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void tickClockInit( const tickClockSource_t * source, int tickMs );
+void tickClockWait();
+uint64_t tickClockNowMs();
+uint32_t tickClockOverruns();
+uint32_t tickClockSkippedTicks();
+
+//=====[#include guards - end]=================================================
+
+#endif // _TICK_CLOCK_H_
@@ -0,0 +1,165 @@
+//=====[Libraries]=============================================================
+
+#include "timer_wheel.h"
+
+#include <stddef.h>
+
+//=====[Declaration of private defines]========================================
+
+#define TIMER_WHEEL_SLOT_MASK   ( TIMER_WHEEL_SLOTS - 1 )
+
+//=====[Declaration and initialization of private global variables]============
+
+// @note Level 0 holds timers due within the next 32 ticks, level 1 within the
+// next 32^2 ticks and so on. A timer is moved one level down ("cascaded")
+// when the digit of the tick counter belonging to its level reaches its slot.
+static timerWheelTimer_t * wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+static uint32_t currentTick = 0;
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static void timerInsert( timerWheelTimer_t * timer );
+static void timerUnlink( timerWheelTimer_t * timer );
+static void slotCascade( int level );
+static uint32_t msToTicks( int ms );
+
+//=====[Implementations of public functions]===================================
+
+void timerWheelInit()
+{
+    int level;
+    int slot;
+
+    for ( level = 0; level < TIMER_WHEEL_LEVELS; level++ ) {
+        for ( slot = 0; slot < TIMER_WHEEL_SLOTS; slot++ ) {
+            wheel[level][slot] = NULL;
+        }
+    }
+    currentTick = 0;
+}
+
+void timerWheelUpdate()
+{
+    timerWheelTimer_t ** slotHead;
+    timerWheelTimer_t * timer;
+    int levelsToCascade = 0;
+    int level;
+
+    currentTick++;
+
+    while ( levelsToCascade < TIMER_WHEEL_LEVELS - 1 &&
+            ( ( currentTick >> ( TIMER_WHEEL_SLOT_BITS * levelsToCascade ) )
+              & TIMER_WHEEL_SLOT_MASK ) == 0 ) {
+        levelsToCascade++;
+    }
+    for ( level = levelsToCascade; level >= 1; level-- ) {
+        slotCascade( level );
+    }
+
+    // @note Re-armed and newly started timers are always at least one tick
+    // ahead, so they never land in the slot being emptied here.
+    slotHead = &wheel[0][currentTick & TIMER_WHEEL_SLOT_MASK];
+    while ( *slotHead != NULL ) {
+        timer = *slotHead;
+        timerUnlink( timer );
+        if ( timer->periodTicks > 0 ) {
+            timer->expiryTick = timer->expiryTick + timer->periodTicks;
+            timerInsert( timer );
+        }
+        timer->callback( timer->context );
+    }
+}
+
+void timerWheelStart( timerWheelTimer_t * timer, int delayMs, int periodMs,
+                      timerWheelCallback_t callback, void * context )
+{
+    if ( timerWheelIsRunning( timer ) ) {
+        timerUnlink( timer );
+    }
+    timer->callback = callback;
+    timer->context = context;
+    timer->periodTicks = ( periodMs > 0 ) ? msToTicks( periodMs ) : 0;
+    timer->expiryTick = currentTick + msToTicks( delayMs );
+    timerInsert( timer );
+}
+
+void timerWheelStop( timerWheelTimer_t * timer )
+{
+    if ( timerWheelIsRunning( timer ) ) {
+        timerUnlink( timer );
+    }
+}
+
+bool timerWheelIsRunning( const timerWheelTimer_t * timer )
+{
+    return timer->pprev != NULL;
+}
+
+int timerWheelPeriodMs( const timerWheelTimer_t * timer )
+{
+    return timer->periodTicks * TIMER_WHEEL_TICK_MS;
+}
+
+uint32_t timerWheelTicks()
+{
+    return currentTick;
+}
+
+//=====[Implementations of private functions]==================================
+
+static void timerInsert( timerWheelTimer_t * timer )
+{
+    timerWheelTimer_t ** slotHead;
+    uint32_t delta = timer->expiryTick - currentTick;
+    int level = 0;
+
+    if ( delta > TIMER_WHEEL_MAX_DELAY_TICKS ) {
+        delta = TIMER_WHEEL_MAX_DELAY_TICKS;
+        timer->expiryTick = currentTick + delta;
+    }
+    while ( level < TIMER_WHEEL_LEVELS - 1 &&
+            delta >= ( 1UL << ( TIMER_WHEEL_SLOT_BITS * ( level + 1 ) ) ) ) {
+        level++;
+    }
+
+    slotHead = &wheel[level][( timer->expiryTick >>
+                              ( TIMER_WHEEL_SLOT_BITS * level ) )
+                             & TIMER_WHEEL_SLOT_MASK];
+    timer->next = *slotHead;
+    if ( timer->next != NULL ) {
+        timer->next->pprev = &timer->next;
+    }
+    timer->pprev = slotHead;
+    *slotHead = timer;
+}
+
+static void timerUnlink( timerWheelTimer_t * timer )
+{
+    *timer->pprev = timer->next;
+    if ( timer->next != NULL ) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+static void slotCascade( int level )
+{
+    timerWheelTimer_t ** slotHead;
+    timerWheelTimer_t * timer;
+
+    slotHead = &wheel[level][( currentTick >> ( TIMER_WHEEL_SLOT_BITS * level ) )
+                             & TIMER_WHEEL_SLOT_MASK];
+    while ( *slotHead != NULL ) {
+        timer = *slotHead;
+        timerUnlink( timer );
+        timerInsert( timer );
+    }
+}
+
+static uint32_t msToTicks( int ms )
+{
+    uint32_t ticks = ( ms + TIMER_WHEEL_TICK_MS - 1 ) / TIMER_WHEEL_TICK_MS;
+
+    return ( ticks > 0 ) ? ticks : 1;
+}
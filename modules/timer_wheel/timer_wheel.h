@@ -0,0 +1,54 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _TIMER_WHEEL_H_
+#define _TIMER_WHEEL_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+#define TIMER_WHEEL_TICK_MS        10
+#define TIMER_WHEEL_LEVELS          4
+#define TIMER_WHEEL_SLOT_BITS       5
+#define TIMER_WHEEL_SLOTS          ( 1 << TIMER_WHEEL_SLOT_BITS )
+
+// Longest delay that can be armed: 32^4 ticks of 10 ms, a bit under 3 hours.
+// Longer delays are clamped to this value.
+#define TIMER_WHEEL_MAX_DELAY_TICKS \
+    ( ( 1UL << ( TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS ) ) - 1 )
+
+//=====[Declaration of public data types]======================================
+
+typedef void (*timerWheelCallback_t)( void * context );
+
+// @note The timer is owned by the caller and must start zero-initialized
+// (usually a static object), so the wheel never allocates memory. The links
+// make insertion and cancellation O(1): pprev points to the previous node's
+// next field or to the slot head.
+typedef struct timerWheelTimer {
+    struct timerWheelTimer * next;
+    struct timerWheelTimer ** pprev;
+    uint32_t expiryTick;
+    uint32_t periodTicks;
+    timerWheelCallback_t callback;
+    void * context;
+} timerWheelTimer_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void timerWheelInit();
+void timerWheelUpdate();
+
+void timerWheelStart( timerWheelTimer_t * timer, int delayMs, int periodMs,
+                      timerWheelCallback_t callback, void * context );
+void timerWheelStop( timerWheelTimer_t * timer );
+bool timerWheelIsRunning( const timerWheelTimer_t * timer );
+int timerWheelPeriodMs( const timerWheelTimer_t * timer );
+
+uint32_t timerWheelTicks();
+
+//=====[#include guards - end]=================================================
+
+#endif // _TIMER_WHEEL_H_
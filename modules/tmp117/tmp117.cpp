@@ -0,0 +1,108 @@
+//=====[Libraries]=============================================================
+
+#include "tmp117.h"
+
+#include "i2c_scheduler.h"
+
+#include <stddef.h>
+
+//=====[Declaration of private defines]========================================
+
+#define TMP117_REGISTER_TEMPERATURE     0x00
+#define TMP117_REGISTER_CONFIGURATION   0x01
+
+// Continuous conversion, 8 averaged conversions, no standby: a new result
+// every 125 ms.
+#define TMP117_CONFIGURATION            0x0020
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static void tmp117TransferDone( void * context, i2cTransferResult_t result );
+
+//=====[Declaration and initialization of private global variables]============
+
+static const uint8_t temperaturePointer = TMP117_REGISTER_TEMPERATURE;
+static uint8_t configurationWrite[3] = {
+    TMP117_REGISTER_CONFIGURATION,
+    TMP117_CONFIGURATION >> 8,
+    TMP117_CONFIGURATION & 0xFF
+};
+static uint8_t temperatureBuffer[2];
+
+static volatile bool readInProgress = false;
+static volatile int16_t temperatureRaw = 0;
+static volatile int consecutiveErrors = 0;
+static volatile bool temperatureValid = false;
+
+//=====[Implementations of public functions]===================================
+
+void tmp117Init()
+{
+    i2cTransaction_t transaction = { TMP117_ADDRESS, configurationWrite, 3,
+                                     NULL, 0, tmp117TransferDone, NULL };
+
+    consecutiveErrors = 0;
+    temperatureValid = false;
+    readInProgress = true;
+    if ( !i2cSchedulerSubmit( &transaction ) ) {
+        readInProgress = false;
+    }
+}
+
+// @note Queues a read of the temperature register and returns at once; the
+// result is picked up by tmp117TransferDone() when the bus completes it. A
+// new read is not queued while the previous one is still pending. The flag
+// is set before submitting, as the transfer may complete, and clear it,
+// before i2cSchedulerSubmit() returns.
+void tmp117Update()
+{
+    i2cTransaction_t transaction = { TMP117_ADDRESS, &temperaturePointer, 1,
+                                     temperatureBuffer, 2,
+                                     tmp117TransferDone, temperatureBuffer };
+
+    if ( readInProgress ) {
+        return;
+    }
+    readInProgress = true;
+    if ( !i2cSchedulerSubmit( &transaction ) ) {
+        readInProgress = false;
+    }
+}
+
+// @note The sensor only counts as present once a temperature has been read,
+// so tmp117RawRead() never returns the initial zero as a reading.
+bool tmp117IsPresent()
+{
+    return temperatureValid &&
+           consecutiveErrors < TMP117_MAX_CONSECUTIVE_ERRORS;
+}
+
+int16_t tmp117RawRead()
+{
+    return temperatureRaw;
+}
+
+float tmp117TemperatureRead()
+{
+    return temperatureRaw * TMP117_RESOLUTION_C;
+}
+
+//=====[Implementations of private functions]==================================
+
+// @note Runs in the I2C interrupt when the real bus is used.
+static void tmp117TransferDone( void * context, i2cTransferResult_t result )
+{
+    if ( result != I2C_TRANSFER_OK ) {
+        if ( consecutiveErrors < TMP117_MAX_CONSECUTIVE_ERRORS ) {
+            consecutiveErrors++;
+        }
+    } else {
+        consecutiveErrors = 0;
+        if ( context == temperatureBuffer ) {
+            temperatureRaw = (int16_t)( ( temperatureBuffer[0] << 8 ) |
+                                        temperatureBuffer[1] );
+            temperatureValid = true;
+        }
+    }
+    readInProgress = false;
+}
@@ -0,0 +1,27 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _TMP117_H_
+#define _TMP117_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+#define TMP117_ADDRESS                  ( 0x48 << 1 )
+#define TMP117_RESOLUTION_C             ( 1.0f / 128.0f )
+#define TMP117_MAX_CONSECUTIVE_ERRORS   3
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void tmp117Init();
+void tmp117Update();
+
+bool tmp117IsPresent();
+int16_t tmp117RawRead();
+float tmp117TemperatureRead();
+
+//=====[#include guards - end]=================================================
+
+#endif // _TMP117_H_
@@ -0,0 +1,182 @@
+//=====[Libraries]=============================================================
+
+#include "mbed.h"
+
+#include "trace.h"
+#include "cycle_counter.h"
+
+#include <stdio.h>
+#include <string.h>
+
+//=====[Declaration of private defines]========================================
+
+// The longest text line of a dump, a TRACE_NAME line.
+#define TRACE_LINE_SIZE                 60
+
+// The ring only takes RAM when tracing is enabled.
+#if TRACE_ENABLED
+#define TRACE_RING_RECORDS              TRACE_RING_SIZE
+#else
+#define TRACE_RING_RECORDS              1
+#endif
+
+//=====[Declaration of private data types]=====================================
+
+typedef struct {
+    uint32_t cycles;
+    char type;
+    uint8_t event;
+    uint16_t argument;
+} traceRecord_t;
+
+typedef struct {
+    const char * name;
+    const char * thread;
+} traceEventName_t;
+
+//=====[Declaration and initialization of private global variables]============
+
+static const traceEventName_t traceEventNames[TRACE_NUMBER_OF_EVENTS] = {
+    { "alarmActivationUpdate", "loop" },
+    { "alarmDeactivationUpdate", "loop" },
+    { "uartTask", "loop" },
+    { "consoleFlush", "loop" },
+    { "timerWheelUpdate", "loop" },
+    { "temperatureSamplingUpdate", "loop" },
+    { "network", "loop" },
+    { "idle", "loop" },
+    { "uartRxInterrupt", "isr" },
+    { "keypadScan", "isr" },
+    { "i2cTransferComplete", "isr" },
+};
+
+// @note The ring keeps the last TRACE_RING_SIZE records, overwriting the
+// oldest ones. recordsWritten only grows, so the oldest record still in the
+// ring is the one after recordsWritten - TRACE_RING_SIZE. At 1 kHz the
+// keypad scan alone would fill it in a quarter of a second, so it is left
+// out of "trace-events" by default.
+static traceRecord_t traceRing[TRACE_RING_RECORDS];
+static volatile uint32_t recordsWritten = 0;
+static volatile bool tracePaused = false;
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static void traceRecordEncode( const traceRecord_t * record,
+                               uint8_t * buffer );
+static int traceDumpStepWrite( const traceDumpCursor_t * cursor,
+                               char * buffer );
+
+//=====[Implementations of public functions]===================================
+
+// @note The cycle counter must be running already; see cycleCounterInit().
+void traceInit()
+{
+    recordsWritten = 0;
+    tracePaused = false;
+}
+
+#if TRACE_ENABLED
+
+void traceRecord( char type, traceEvent_t event, uint16_t argument )
+{
+    traceRecord_t * record;
+
+    core_util_critical_section_enter();
+    if ( !tracePaused ) {
+        record = &traceRing[recordsWritten % TRACE_RING_SIZE];
+        record->cycles = cycleCounterRead();
+        record->type = type;
+        record->event = event;
+        record->argument = argument;
+        recordsWritten++;
+    }
+    core_util_critical_section_exit();
+}
+
+#endif
+
+int traceLength()
+{
+    return ( recordsWritten < TRACE_RING_SIZE ) ? recordsWritten :
+                                                  TRACE_RING_SIZE;
+}
+
+// @note Text header, one line per event name, the records in binary
+// (oldest first, TRACE_RECORD_SIZE bytes each, little endian: cycles,
+// type, event, argument) and an end line; tools/trace_convert.py turns it
+// into a Chrome trace. Recording stops from here to the end line, so the
+// UART writes of the dump are not traced and the ring is not overwritten
+// while it is sent, and starts again on an empty ring.
+void traceDumpStart( traceDumpCursor_t * cursor )
+{
+    tracePaused = true;
+    cursor->length = traceLength();
+    cursor->first = recordsWritten - cursor->length;
+    cursor->step = 0;
+}
+
+// @note Writes the next steps of the dump, at most maxBytes of them but at
+// least one, and returns whether any are left, so a dump of a few KB can be
+// sent a TX buffer at a time.
+bool traceDumpNext( traceDumpCursor_t * cursor, int maxBytes,
+                    traceWrite_t write )
+{
+    char buffer[TRACE_LINE_SIZE];
+    int steps = 1 + TRACE_NUMBER_OF_EVENTS + cursor->length + 1;
+    int bytes = 0;
+    int length;
+
+    while ( cursor->step < steps ) {
+        length = traceDumpStepWrite( cursor, buffer );
+        if ( bytes > 0 && bytes + length > maxBytes ) {
+            return true;
+        }
+        write( buffer, length );
+        bytes += length;
+        cursor->step++;
+    }
+
+    recordsWritten = 0;
+    tracePaused = false;
+    return false;
+}
+
+//=====[Implementations of private functions]==================================
+
+// @note Returns the length of the step, which is not null terminated.
+static int traceDumpStepWrite( const traceDumpCursor_t * cursor,
+                               char * buffer )
+{
+    int i = cursor->step;
+
+    if ( i == 0 ) {
+        return sprintf( buffer, "TRACE,%lu,%d,%d\r\n",
+                        (unsigned long)SystemCoreClock, cursor->length,
+                        TRACE_NUMBER_OF_EVENTS );
+    }
+    i--;
+    if ( i < TRACE_NUMBER_OF_EVENTS ) {
+        return sprintf( buffer, "TRACE_NAME,%d,%s,%s\r\n", i,
+                        traceEventNames[i].name, traceEventNames[i].thread );
+    }
+    i -= TRACE_NUMBER_OF_EVENTS;
+    if ( i < cursor->length ) {
+        traceRecordEncode( &traceRing[( cursor->first + i ) % TRACE_RING_SIZE],
+                           (uint8_t *)buffer );
+        return TRACE_RECORD_SIZE;
+    }
+    memcpy( buffer, "TRACE,END\r\n", 11 );
+    return 11;
+}
+
+static void traceRecordEncode( const traceRecord_t * record, uint8_t * buffer )
+{
+    buffer[0] = record->cycles & 0xFF;
+    buffer[1] = ( record->cycles >> 8 ) & 0xFF;
+    buffer[2] = ( record->cycles >> 16 ) & 0xFF;
+    buffer[3] = ( record->cycles >> 24 ) & 0xFF;
+    buffer[4] = record->type;
+    buffer[5] = record->event;
+    buffer[6] = record->argument & 0xFF;
+    buffer[7] = record->argument >> 8;
+}
@@ -0,0 +1,103 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+//=====[Libraries]=============================================================
+
+#include "mbed.h"
+
+//=====[Declaration of public defines]=========================================
+
+#define TRACE_ENABLED                   MBED_CONF_APP_TRACE_ENABLED
+#define TRACE_EVENTS                    MBED_CONF_APP_TRACE_EVENTS
+#define TRACE_RING_SIZE                 512
+#define TRACE_RECORD_SIZE               8
+
+#define TRACE_BEGIN                     'B'
+#define TRACE_END                       'E'
+#define TRACE_INSTANT                   'i'
+
+//=====[Declaration of public data types]======================================
+
+// @note New events go at the end, so that older traces still convert. The
+// names sent with every dump come from traceEventNames in trace.cpp.
+typedef enum {
+    TRACE_EVENT_ALARM_ACTIVATION,
+    TRACE_EVENT_ALARM_DEACTIVATION,
+    TRACE_EVENT_UART_TASK,
+    TRACE_EVENT_CONSOLE_FLUSH,
+    TRACE_EVENT_TIMER_WHEEL,
+    TRACE_EVENT_TEMPERATURE_SAMPLING,
+    TRACE_EVENT_NETWORK,
+    TRACE_EVENT_IDLE,
+    TRACE_EVENT_UART_RX_ISR,
+    TRACE_EVENT_KEYPAD_SCAN_ISR,
+    TRACE_EVENT_I2C_COMPLETE,
+    TRACE_NUMBER_OF_EVENTS
+} traceEvent_t;
+
+typedef void (*traceWrite_t)( const char * buffer, int length );
+
+// @note Position in a dump: step 0 is the header line, then one step per
+// event name, one per record and the end line.
+typedef struct {
+    uint32_t first;
+    int length;
+    int step;
+} traceDumpCursor_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+#if TRACE_ENABLED
+
+void traceRecord( char type, traceEvent_t event, uint16_t argument );
+
+#else
+
+static inline void traceRecord( char type, traceEvent_t event,
+                                uint16_t argument )
+{
+}
+
+#endif
+
+// @note Cheap enough for interrupts: one critical section and an 8-byte
+// store, and nothing at all unless "trace-enabled" is set and the event is
+// selected by "trace-events". The event is a constant at every call, so an
+// event left out costs nothing either.
+static inline bool traceEventSelected( traceEvent_t event )
+{
+    return ( TRACE_EVENTS >> event ) & 1;
+}
+
+static inline void traceBegin( traceEvent_t event )
+{
+    if ( traceEventSelected( event ) ) {
+        traceRecord( TRACE_BEGIN, event, 0 );
+    }
+}
+
+static inline void traceEnd( traceEvent_t event )
+{
+    if ( traceEventSelected( event ) ) {
+        traceRecord( TRACE_END, event, 0 );
+    }
+}
+
+static inline void traceInstant( traceEvent_t event, uint16_t argument )
+{
+    if ( traceEventSelected( event ) ) {
+        traceRecord( TRACE_INSTANT, event, argument );
+    }
+}
+
+void traceInit();
+int traceLength();
+void traceDumpStart( traceDumpCursor_t * cursor );
+bool traceDumpNext( traceDumpCursor_t * cursor, int maxBytes,
+                    traceWrite_t write );
+
+//=====[#include guards - end]=================================================
+
+#endif // _TRACE_H_
@@ -0,0 +1,177 @@
+//=====[Libraries]=============================================================
+
+#include "mbed.h"
+
+#include "udp_endpoint.h"
+
+#if MBED_CONF_APP_UDP_ENABLED
+
+#include "network.h"
+#include "timer_wheel.h"
+
+//=====[Declaration of private defines]========================================
+
+#define UDP_RX_BUFFER_SIZE          16
+#define UDP_OPEN_RETRY_TIME         NETWORK_CONNECT_RETRY_TIME
+
+//=====[Declaration and initialization of private global objects]==============
+
+static UDPSocket socket;
+static SocketAddress telemetryAddress;
+
+//=====[Declaration and initialization of private global variables]============
+
+static bool socketOpen = false;
+static bool openRetryDue = true;
+static nsapi_error_t socketError = NSAPI_ERROR_OK;
+static timerWheelTimer_t openRetryTimer;
+static statusReportGet_t statusReportRead = NULL;
+static timerWheelTimer_t telemetryTimer;
+static bool telemetryEnabled = false;
+static bool telemetryDue = false;
+static uint16_t sequence = 0;
+
+// @note Both buffers are allocated once; answering a query or pushing
+// telemetry never allocates memory in the application.
+static uint8_t rxBuffer[UDP_RX_BUFFER_SIZE];
+static uint8_t txBuffer[STATUS_REPORT_ENCODED_SIZE];
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static bool socketOpenAndBind();
+static int statusFrameBuild();
+static void telemetryTimerExpired( void * context );
+static void openRetryTimerExpired( void * context );
+
+//=====[Implementations of public functions]===================================
+
+void udpEndpointInit( statusReportGet_t statusReportGet )
+{
+    statusReportRead = statusReportGet;
+
+    telemetryEnabled = ( strlen( MBED_CONF_APP_UDP_TELEMETRY_HOST ) > 0 ) &&
+                       telemetryAddress.set_ip_address( MBED_CONF_APP_UDP_TELEMETRY_HOST );
+    telemetryAddress.set_port( MBED_CONF_APP_UDP_TELEMETRY_PORT );
+    timerWheelStart( &telemetryTimer, MBED_CONF_APP_UDP_TELEMETRY_PERIOD_MS,
+                     MBED_CONF_APP_UDP_TELEMETRY_PERIOD_MS,
+                     telemetryTimerExpired, NULL );
+    socketOpen = false;
+    openRetryDue = true;
+    socketError = NSAPI_ERROR_OK;
+}
+
+// @note Called once per control loop tick. Every socket call is
+// non-blocking, so the endpoint never stalls the loop. When the socket
+// cannot be opened or bound, the error is kept for udpEndpointError() and
+// the socket is tried again after UDP_OPEN_RETRY_TIME.
+void udpEndpointUpdate()
+{
+    SocketAddress peer;
+    nsapi_size_or_error_t received;
+    int length;
+
+    if ( !networkIsUp() ) {
+        if ( socketOpen ) {
+            socket.close();
+            socketOpen = false;
+        }
+        openRetryDue = true;
+        return;
+    }
+    if ( !socketOpen ) {
+        if ( !openRetryDue ) {
+            return;
+        }
+        openRetryDue = false;
+        socketOpen = socketOpenAndBind();
+        if ( !socketOpen ) {
+            timerWheelStart( &openRetryTimer, UDP_OPEN_RETRY_TIME, 0,
+                             openRetryTimerExpired, NULL );
+            return;
+        }
+    }
+
+    received = socket.recvfrom( &peer, rxBuffer, sizeof( rxBuffer ) );
+    if ( received > 0 && rxBuffer[0] == UDP_ENDPOINT_STATUS_QUERY ) {
+        length = statusFrameBuild();
+        socket.sendto( peer, txBuffer, length );
+    }
+
+    if ( telemetryDue ) {
+        telemetryDue = false;
+        if ( telemetryEnabled ) {
+            length = statusFrameBuild();
+            socket.sendto( telemetryAddress, txBuffer, length );
+        }
+    }
+}
+
+bool udpEndpointIsConnected()
+{
+    return socketOpen;
+}
+
+int udpEndpointError()
+{
+    return socketError;
+}
+
+//=====[Implementations of private functions]==================================
+
+static bool socketOpenAndBind()
+{
+    socketError = socket.open( networkInterface() );
+    if ( socketError != NSAPI_ERROR_OK ) {
+        return false;
+    }
+    socketError = socket.bind( MBED_CONF_APP_UDP_PORT );
+    if ( socketError != NSAPI_ERROR_OK ) {
+        socket.close();
+        return false;
+    }
+    socket.set_blocking( false );
+    return true;
+}
+
+static int statusFrameBuild()
+{
+    statusReport_t report;
+
+    statusReportRead( &report );
+    report.sequence = sequence++;
+    return statusReportEncode( &report, txBuffer, sizeof( txBuffer ) );
+}
+
+static void telemetryTimerExpired( void * context )
+{
+    telemetryDue = true;
+}
+
+static void openRetryTimerExpired( void * context )
+{
+    openRetryDue = true;
+}
+
+#else
+
+//=====[Implementations of public functions]===================================
+
+void udpEndpointInit( statusReportGet_t statusReportGet )
+{
+}
+
+void udpEndpointUpdate()
+{
+}
+
+bool udpEndpointIsConnected()
+{
+    return false;
+}
+
+int udpEndpointError()
+{
+    return 0;
+}
+
+#endif // MBED_CONF_APP_UDP_ENABLED
@@ -0,0 +1,27 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _UDP_ENDPOINT_H_
+#define _UDP_ENDPOINT_H_
+
+//=====[Libraries]=============================================================
+
+#include "status_report.h"
+
+//=====[Declaration of public defines]=========================================
+
+#define UDP_ENDPOINT_STATUS_QUERY       'S'
+
+//=====[Declaration of public data types]======================================
+
+typedef void (*statusReportGet_t)( statusReport_t * report );
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void udpEndpointInit( statusReportGet_t statusReportGet );
+void udpEndpointUpdate();
+bool udpEndpointIsConnected();
+int udpEndpointError();
+
+//=====[#include guards - end]=================================================
+
+#endif // _UDP_ENDPOINT_H_
@@ -0,0 +1,263 @@
+// Check of the delta-of-delta codec and of the sample history built on it:
+// ramps, steps and the extreme deltas between INT32_MIN and INT32_MAX must
+// round-trip, a full buffer must reject a sample without losing the ones
+// before it, and a history cursor must keep walking the samples in order
+// when the oldest blocks are overwritten under it.
+//
+//     build/delta_codec_check
+
+#include "delta_codec.h"
+#include "sample_history.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#define BUFFER_SIZE             4096
+#define HISTORY_PERIOD_MS       10
+#define HISTORY_CHUNK           7
+
+static int failures = 0;
+
+static void check( bool condition, const char * what )
+{
+    if ( !condition ) {
+        printf( "FAIL: %s\n", what );
+        failures++;
+    }
+}
+
+//=====[Codec]=================================================================
+
+// @note Encodes the series into a buffer large enough for all of it, checks
+// the size of every sample and decodes it back. Returns the encoded length.
+static int roundTrip( const char * name, const std::vector<int32_t> & series )
+{
+    static uint8_t buffer[BUFFER_SIZE];
+    deltaEncoder_t encoder;
+    deltaDecoder_t decoder;
+    int32_t value;
+    int previousLength;
+    size_t i;
+    bool ok = true;
+
+    deltaEncoderInit( &encoder, buffer, sizeof( buffer ) );
+    for ( i = 0; i < series.size(); i++ ) {
+        previousLength = encoder.length;
+        ok = deltaEncoderAdd( &encoder, series[i] ) && ok;
+        ok = encoder.length - previousLength <= DELTA_CODEC_MAX_SAMPLE_SIZE &&
+             ok;
+    }
+    check( ok, "every sample encoded within the maximum size" );
+    check( encoder.samples == series.size(), "encoded sample count" );
+
+    deltaDecoderInit( &decoder, buffer, encoder.length );
+    for ( i = 0; i < series.size(); i++ ) {
+        if ( !deltaDecoderNext( &decoder, &value ) || value != series[i] ) {
+            break;
+        }
+    }
+    check( i == series.size(), "series decoded back" );
+    check( !deltaDecoderNext( &decoder, &value ), "nothing after the end" );
+
+    printf( "%-24s %5zu samples in %5d bytes\n", name, series.size(),
+            encoder.length );
+    return encoder.length;
+}
+
+static void roundTripChecks()
+{
+    std::vector<int32_t> series;
+    int length;
+    int i;
+
+    for ( i = 0; i < 1000; i++ ) {
+        series.push_back( 2500 + 3 * i );
+    }
+    length = roundTrip( "ramp", series );
+    check( length == 2 + 1 + 998, "a ramp costs one byte per sample" );
+
+    series.clear();
+    for ( i = 0; i < 1000; i++ ) {
+        series.push_back( 2500 - 7 * i );
+    }
+    roundTrip( "falling ramp", series );
+
+    series.clear();
+    for ( i = 0; i < 1000; i++ ) {
+        series.push_back( ( i / 100 ) % 2 ? 8000 : -1500 );
+    }
+    roundTrip( "steps", series );
+
+    series.clear();
+    for ( i = 0; i < 100; i++ ) {
+        series.push_back( i % 2 ? INT32_MAX : INT32_MIN );
+    }
+    roundTrip( "INT32_MIN/MAX swings", series );
+
+    series.clear();
+    series.push_back( 0 );
+    series.push_back( INT32_MIN );
+    series.push_back( 0 );
+    series.push_back( INT32_MAX );
+    series.push_back( INT32_MAX );
+    series.push_back( -1 );
+    series.push_back( INT32_MIN );
+    series.push_back( INT32_MIN );
+    series.push_back( 1 );
+    roundTrip( "INT32_MIN/MAX deltas", series );
+}
+
+// @note A rejected sample must leave the encoder as it was, so a smaller
+// sample may still fit, and the samples already in the buffer decode.
+static void fullBufferCheck()
+{
+    uint8_t buffer[3];
+    deltaEncoder_t encoder;
+    deltaDecoder_t decoder;
+    int32_t value;
+
+    deltaEncoderInit( &encoder, buffer, sizeof( buffer ) );
+    check( deltaEncoderAdd( &encoder, 100 ), "first sample fits" );
+    check( encoder.length == 2, "first sample takes two bytes" );
+    check( !deltaEncoderAdd( &encoder, INT32_MAX ), "large sample rejected" );
+    check( encoder.length == 2 && encoder.samples == 1,
+           "rejected sample adds nothing" );
+    check( deltaEncoderAdd( &encoder, 101 ), "small sample still fits" );
+    check( !deltaEncoderAdd( &encoder, 102 ), "full buffer rejects" );
+    check( encoder.length == 3 && encoder.samples == 2,
+           "full buffer keeps its samples" );
+
+    deltaDecoderInit( &decoder, buffer, encoder.length );
+    check( deltaDecoderNext( &decoder, &value ) && value == 100,
+           "first sample decoded" );
+    check( deltaDecoderNext( &decoder, &value ) && value == 101,
+           "second sample decoded" );
+    check( !deltaDecoderNext( &decoder, &value ), "end of a full buffer" );
+
+    deltaDecoderInit( &decoder, buffer, 1 );
+    check( !deltaDecoderNext( &decoder, &value ), "truncated sample refused" );
+}
+
+//=====[Sample history]========================================================
+
+// @note Values are a function of the sample number, which the visitor
+// recovers from the time, so every visited sample can be checked.
+static int32_t historyValue( uint32_t sample )
+{
+    return 2000 + (int32_t)( sample / 3 ) + (int32_t)( sample % 5 );
+}
+
+static void historyAdd( uint32_t * samples, int count )
+{
+    int i;
+
+    for ( i = 0; i < count; i++ ) {
+        sampleHistoryAdd( *samples * HISTORY_PERIOD_MS,
+                          historyValue( *samples ) );
+        ( *samples )++;
+    }
+}
+
+typedef struct {
+    uint32_t visited;
+    uint32_t last;
+    bool ordered;
+    bool valuesMatch;
+} historyWalk_t;
+
+static void historyVisit( uint32_t timeMs, int32_t value, void * context )
+{
+    historyWalk_t * walk = (historyWalk_t *)context;
+    uint32_t sample = timeMs / HISTORY_PERIOD_MS;
+
+    if ( walk->visited > 0 && sample <= walk->last ) {
+        walk->ordered = false;
+    }
+    if ( value != historyValue( sample ) ) {
+        walk->valuesMatch = false;
+    }
+    walk->last = sample;
+    walk->visited++;
+}
+
+static void historyWalkInit( historyWalk_t * walk )
+{
+    walk->visited = 0;
+    walk->last = 0;
+    walk->ordered = true;
+    walk->valuesMatch = true;
+}
+
+// @note Enough samples are added for the blocks to wrap before the cursor is
+// set; then, halfway through the walk, enough more to overwrite the block
+// the cursor is in and those after it.
+static void historyCursorCheck()
+{
+    sampleHistoryCursor_t cursor;
+    historyWalk_t walk;
+    uint32_t samples = 0;
+    uint32_t stored;
+    uint32_t firstAfterOverwrite;
+    bool more;
+
+    sampleHistoryInit( HISTORY_PERIOD_MS );
+    sampleHistoryCursorInit( &cursor );
+    historyWalkInit( &walk );
+    check( !sampleHistoryForEachNext( &cursor, HISTORY_CHUNK, historyVisit,
+                                      &walk ) && walk.visited == 0,
+           "empty history" );
+
+    historyAdd( &samples, 5000 );
+    stored = sampleHistorySamples();
+    check( stored < samples, "oldest blocks overwritten" );
+    check( sampleHistoryBytes() <=
+           SAMPLE_HISTORY_BLOCKS * SAMPLE_HISTORY_BLOCK_SIZE, "history size" );
+
+    sampleHistoryCursorInit( &cursor );
+    historyWalkInit( &walk );
+    do {
+        more = sampleHistoryForEachNext( &cursor, HISTORY_CHUNK, historyVisit,
+                                         &walk );
+    } while ( more );
+    check( walk.visited == stored, "cursor visits every stored sample" );
+    check( walk.last == samples - 1, "cursor ends at the newest sample" );
+    check( walk.ordered && walk.valuesMatch, "stored samples in order" );
+
+    sampleHistoryCursorInit( &cursor );
+    historyWalkInit( &walk );
+    while ( walk.visited < stored / 2 ) {
+        sampleHistoryForEachNext( &cursor, HISTORY_CHUNK, historyVisit,
+                                  &walk );
+    }
+    historyAdd( &samples, stored * 3 / 4 );
+    firstAfterOverwrite = samples - sampleHistorySamples();
+    check( cursor.next < firstAfterOverwrite, "cursor block overwritten" );
+    do {
+        more = sampleHistoryForEachNext( &cursor, HISTORY_CHUNK, historyVisit,
+                                         &walk );
+    } while ( more );
+    check( walk.ordered && walk.valuesMatch,
+           "samples in order across the overwrite" );
+    check( walk.last == cursor.end - 1, "cursor stops at its end" );
+    check( walk.visited < stored, "overwritten samples skipped" );
+
+    printf( "history: %lu samples in %d bytes, %lu visited across an "
+            "overwrite\n", (unsigned long)sampleHistorySamples(),
+            sampleHistoryBytes(), (unsigned long)walk.visited );
+}
+
+int main()
+{
+    roundTripChecks();
+    fullBufferCheck();
+    historyCursorCheck();
+
+    if ( failures > 0 ) {
+        printf( "%d failures\n", failures );
+        return 1;
+    }
+    printf( "Delta codec round-trips and the history cursor survives "
+            "overwrites\n" );
+    return 0;
+}
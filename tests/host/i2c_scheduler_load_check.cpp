@@ -0,0 +1,266 @@
+// Load check of the I2C scheduler on the simulated bus: several clients
+// (TMP117 reads, PCF8574 write bursts as the LCD does, and a missing device)
+// submit at random against a bus that completes transfers at random. Every
+// accepted transaction must be completed exactly once, in submission order,
+// with the right result and data; a transaction is only rejected with the
+// queue full, and the statistics must add up. A summary line per load level
+// shows the queue depth and the latency in bus steps.
+
+#include "i2c_bus.h"
+#include "i2c_scheduler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUMBER_OF_STEPS         200000
+#define POOL_SIZE               64
+#define MISSING_ADDRESS         ( 0x50 << 1 )
+
+typedef enum {
+    CLIENT_TMP117,
+    CLIENT_PCF8574,
+    CLIENT_MISSING,
+    NUMBER_OF_CLIENTS
+} client_t;
+
+typedef struct {
+    client_t client;
+    uint32_t sequence;
+    long submittedAt;
+    int16_t expectedTemperature;
+    uint8_t txData[4];
+    uint8_t rxData[2];
+} request_t;
+
+static request_t pool[POOL_SIZE];
+static int poolNext = 0;
+
+static uint32_t submittedSequence = 0;
+static uint32_t completedSequence = 0;
+static long step = 0;
+static long latencySum = 0;
+static long latencyMax = 0;
+static uint32_t accepted = 0;
+static uint32_t rejected = 0;
+static uint32_t completions = 0;
+static uint32_t expectedErrors = 0;
+static int failures = 0;
+
+static void check( bool condition, const char * what )
+{
+    if ( !condition ) {
+        if ( failures < 10 ) {
+            printf( "FAIL: %s at step %ld\n", what, step );
+        }
+        failures++;
+    }
+}
+
+static void transferDone( void * context, i2cTransferResult_t result )
+{
+    request_t * request = (request_t *)context;
+    int16_t temperature;
+    long latency = step - request->submittedAt;
+
+    check( request->sequence == completedSequence, "completion order" );
+    completedSequence = request->sequence + 1;
+    completions++;
+    latencySum += latency;
+    if ( latency > latencyMax ) {
+        latencyMax = latency;
+    }
+
+    switch ( request->client ) {
+    case CLIENT_TMP117:
+        check( result == I2C_TRANSFER_OK, "TMP117 read acknowledged" );
+        temperature = (int16_t)( ( request->rxData[0] << 8 ) |
+                                 request->rxData[1] );
+        check( temperature == request->expectedTemperature,
+               "TMP117 temperature" );
+        break;
+    case CLIENT_PCF8574:
+        check( result == I2C_TRANSFER_OK, "PCF8574 write acknowledged" );
+        break;
+    case CLIENT_MISSING:
+        check( result == I2C_TRANSFER_ERROR, "missing device not acknowledged" );
+        expectedErrors++;
+        break;
+    default:
+        break;
+    }
+}
+
+// @note The simulated TMP117 only changes temperature between transfers, so
+// the expected value is the one set when the read is submitted as long as
+// no other temperature is set while it is queued: the temperature only
+// changes while the queue is empty.
+static void submit( client_t client, int16_t temperature )
+{
+    request_t * request = &pool[poolNext];
+    i2cTransaction_t transaction;
+    int depthBefore = i2cSchedulerQueueDepth();
+    int i;
+
+    request->client = client;
+    request->sequence = submittedSequence;
+    request->submittedAt = step;
+    request->expectedTemperature = temperature;
+    transaction.callback = transferDone;
+    transaction.context = request;
+    transaction.rxData = request->rxData;
+    transaction.txData = request->txData;
+
+    switch ( client ) {
+    case CLIENT_TMP117:
+        transaction.address = I2C_SIMULATED_TMP117_ADDRESS;
+        request->txData[0] = 0x00;
+        transaction.txLength = 1;
+        transaction.rxLength = 2;
+        break;
+    case CLIENT_PCF8574:
+        transaction.address = I2C_SIMULATED_PCF8574_ADDRESS;
+        for ( i = 0; i < 4; i++ ) {
+            request->txData[i] = rand() & 0xFF;
+        }
+        transaction.txLength = 4;
+        transaction.rxLength = 0;
+        break;
+    default:
+        transaction.address = MISSING_ADDRESS;
+        request->txData[0] = 0x00;
+        transaction.txLength = 1;
+        transaction.rxLength = 0;
+        break;
+    }
+
+    if ( i2cSchedulerSubmit( &transaction ) ) {
+        check( depthBefore < I2C_SCHEDULER_QUEUE_SIZE, "accepted when full" );
+        poolNext = ( poolNext + 1 ) % POOL_SIZE;
+        submittedSequence++;
+        accepted++;
+    } else {
+        check( depthBefore == I2C_SCHEDULER_QUEUE_SIZE,
+               "rejected with room in the queue" );
+        rejected++;
+    }
+}
+
+// @note Each step every client submits with probability submitPercent and
+// the bus completes the transfer in progress with probability
+// completePercent, so submitPercent * 3 / completePercent is the offered
+// load.
+static void loadRun( int submitPercent, int completePercent )
+{
+    i2cSchedulerStats_t stats;
+    i2cSimulatedBusStats_t busStats;
+    int16_t temperature = 25 * 128;
+    int client;
+
+    i2cSchedulerInit( &i2cSimulatedBus );
+    i2cSimulatedBusTemperatureSet( temperature / 128.0f );
+    submittedSequence = 0;
+    completedSequence = 0;
+    latencySum = 0;
+    latencyMax = 0;
+    accepted = 0;
+    rejected = 0;
+    completions = 0;
+    expectedErrors = 0;
+
+    for ( step = 0; step < NUMBER_OF_STEPS; step++ ) {
+        if ( i2cSchedulerQueueDepth() == 0 && rand() % 100 == 0 ) {
+            temperature = (int16_t)( ( rand() % 20000 ) - 5000 );
+            i2cSimulatedBusTemperatureSet( temperature / 128.0f );
+        }
+        for ( client = 0; client < NUMBER_OF_CLIENTS; client++ ) {
+            if ( rand() % 100 < submitPercent ) {
+                submit( (client_t)client, temperature );
+            }
+        }
+        if ( rand() % 100 < completePercent ) {
+            i2cSimulatedBusUpdate();
+        }
+        i2cSchedulerUpdate();
+        check( i2cSchedulerQueueDepth() >= 0 &&
+               i2cSchedulerQueueDepth() <= I2C_SCHEDULER_QUEUE_SIZE,
+               "queue depth in range" );
+    }
+    while ( i2cSchedulerQueueDepth() > 0 ) {
+        i2cSimulatedBusUpdate();
+        i2cSchedulerUpdate();
+        step++;
+    }
+
+    i2cSchedulerStatsGet( &stats );
+    i2cSimulatedBusStatsGet( &busStats );
+    check( completions == accepted, "every accepted transaction completed" );
+    check( stats.submitted == accepted, "submitted count" );
+    check( stats.completed == completions, "completed count" );
+    check( stats.rejected == rejected, "rejected count" );
+    check( stats.errors == expectedErrors, "error count" );
+    check( busStats.nacks == expectedErrors, "bus NACK count" );
+    check( stats.maxQueueDepth <= I2C_SCHEDULER_QUEUE_SIZE, "max depth" );
+
+    printf( "load %3d%%: %6lu accepted, %6lu rejected, max depth %d, "
+            "latency mean %.1f max %ld steps\n",
+            submitPercent * NUMBER_OF_CLIENTS * 100 / completePercent,
+            (unsigned long)accepted, (unsigned long)rejected,
+            stats.maxQueueDepth, completions ? (double)latencySum / completions : 0.0,
+            latencyMax );
+}
+
+// @note A callback that submits the next transaction, as a driver chaining
+// its steps does, must find the scheduler consistent: with the queue
+// emptied by the completion, the new transfer starts at once, as the
+// simulated bus completes from task context.
+static int chainedLeft = 0;
+
+static void chainedDone( void * context, i2cTransferResult_t result )
+{
+    static const uint8_t data = 0x55;
+    i2cTransaction_t transaction = { I2C_SIMULATED_PCF8574_ADDRESS, &data, 1,
+                                     NULL, 0, chainedDone, NULL };
+
+    check( result == I2C_TRANSFER_OK, "chained transfer acknowledged" );
+    if ( chainedLeft > 0 ) {
+        chainedLeft--;
+        check( i2cSchedulerSubmit( &transaction ), "chained submit" );
+    }
+}
+
+static void chainedRun()
+{
+    static const uint8_t data = 0xAA;
+    i2cTransaction_t transaction = { I2C_SIMULATED_PCF8574_ADDRESS, &data, 1,
+                                     NULL, 0, chainedDone, NULL };
+    i2cSchedulerStats_t stats;
+    int updates = 0;
+
+    i2cSchedulerInit( &i2cSimulatedBus );
+    chainedLeft = 100;
+    check( i2cSchedulerSubmit( &transaction ), "first chained submit" );
+    while ( i2cSchedulerQueueDepth() > 0 && updates < 1000 ) {
+        i2cSimulatedBusUpdate();
+        updates++;
+    }
+    i2cSchedulerStatsGet( &stats );
+    check( chainedLeft == 0, "chain finished" );
+    check( stats.completed == 101 && updates == 101, "one update per transfer" );
+}
+
+int main()
+{
+    srand( 1 );
+    loadRun( 5, 50 );
+    loadRun( 10, 40 );
+    loadRun( 20, 60 );
+    loadRun( 50, 50 );
+    chainedRun();
+
+    if ( failures > 0 ) {
+        printf( "%d failures\n", failures );
+        return 1;
+    }
+    printf( "I2C scheduler kept order and accounting under load\n" );
+    return 0;
+}
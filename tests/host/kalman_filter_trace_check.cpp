@@ -0,0 +1,313 @@
+// Benchmark of the Kalman estimate against the 100-sample moving average it
+// replaces in the vote, over temperature traces in hundredths of a degree:
+// the lag behind a ramp and the noise left at a steady temperature, for a
+// range of process noise settings (the lag versus noise trade-off). The
+// built-in traces are synthetic, with known truth; traces recorded with the
+// 'h' command ("time (ms),temperature" lines) can be given as arguments, and
+// are then compared with a centred, lag-free average of themselves. It also
+// checks that measurements beyond the Q16.16 range saturate instead of
+// wrapping the estimate.
+//
+//     build/kalman_filter_trace_check [trace.csv ...]
+
+#include "kalman_filter.h"
+#include "moving_average.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#define PERIOD_MS               10
+#define MEASUREMENT_NOISE       20.0f
+#define AVERAGE_SAMPLES         100
+#define REFERENCE_HALF_WINDOW   50
+#define MAX_LAG_SAMPLES         300
+#define LM35_FULL_SCALE         33000
+
+typedef struct {
+    const char * name;
+    int periodMs;
+    std::vector<int32_t> measured;
+    std::vector<float> truth;
+    size_t steadyEnd;
+} trace_t;
+
+typedef struct {
+    float lagMs;
+    float noise;
+} result_t;
+
+static const float processNoises[] = { 10.0f, 50.0f, 200.0f, 1000.0f };
+
+static int failures = 0;
+
+static void check( bool condition, const char * what )
+{
+    if ( !condition ) {
+        printf( "FAIL: %s\n", what );
+        failures++;
+    }
+}
+
+//=====[Traces]================================================================
+
+static float gaussian()
+{
+    float u1 = ( rand() + 1.0f ) / ( RAND_MAX + 2.0f );
+    float u2 = ( rand() + 1.0f ) / ( RAND_MAX + 2.0f );
+
+    return sqrtf( -2.0f * logf( u1 ) ) * cosf( 6.2831853f * u2 );
+}
+
+// @note 25 C for 20 s, then a 0.5 C/s rise for 20 s, sampled every 10 ms
+// with MEASUREMENT_NOISE of white noise, as the default tuning assumes.
+static void rampTraceMake( trace_t * trace )
+{
+    float truth;
+    int i;
+
+    trace->name = "synthetic ramp";
+    trace->periodMs = PERIOD_MS;
+    trace->steadyEnd = 20000 / PERIOD_MS;
+    for ( i = 0; i < 40000 / PERIOD_MS; i++ ) {
+        truth = 2500.0f;
+        if ( (size_t)i >= trace->steadyEnd ) {
+            truth += 50.0f * ( i - trace->steadyEnd ) * PERIOD_MS / 1000.0f;
+        }
+        trace->truth.push_back( truth );
+        trace->measured.push_back(
+            (int32_t)lrintf( truth + MEASUREMENT_NOISE * gaussian() ) );
+    }
+}
+
+// @note Lines that do not start with a number, such as the summary line of
+// the report, are skipped; the period is taken from the first two samples.
+static bool recordedTraceLoad( trace_t * trace, const char * path )
+{
+    FILE * file = fopen( path, "r" );
+    char line[80];
+    unsigned long timeMs;
+    unsigned long firstTimeMs = 0;
+    long value;
+    int samples = 0;
+
+    if ( file == NULL ) {
+        return false;
+    }
+    trace->name = path;
+    trace->periodMs = 0;
+    while ( fgets( line, sizeof( line ), file ) != NULL ) {
+        if ( sscanf( line, "%lu,%ld", &timeMs, &value ) != 2 ) {
+            continue;
+        }
+        if ( samples == 0 ) {
+            firstTimeMs = timeMs;
+        } else if ( samples == 1 ) {
+            trace->periodMs = (int)( timeMs - firstTimeMs );
+        }
+        trace->measured.push_back( (int32_t)value );
+        samples++;
+    }
+    fclose( file );
+    trace->steadyEnd = trace->measured.size();
+    return samples > 2 * REFERENCE_HALF_WINDOW && trace->periodMs > 0;
+}
+
+// @note Centred average of the measurements: it has no lag, so it stands for
+// the truth of a recorded trace. The ends, without a full window, are left
+// out of the results.
+static void referenceMake( trace_t * trace )
+{
+    size_t i;
+    int j;
+    float sum;
+
+    trace->truth.assign( trace->measured.size(), NAN );
+    for ( i = REFERENCE_HALF_WINDOW;
+          i + REFERENCE_HALF_WINDOW < trace->measured.size(); i++ ) {
+        sum = 0.0f;
+        for ( j = -REFERENCE_HALF_WINDOW; j <= REFERENCE_HALF_WINDOW; j++ ) {
+            sum += trace->measured[i + j];
+        }
+        trace->truth[i] = sum / ( 2 * REFERENCE_HALF_WINDOW + 1 );
+    }
+}
+
+//=====[Estimators]============================================================
+
+// @note The firmware averages raw counts of the LM35 input, so the
+// measurements are turned into counts and back.
+static void averageRun( const trace_t * trace, std::vector<float> * estimate )
+{
+    static movingAverage_t filter;
+    long counts;
+    size_t i;
+
+    movingAverageInit( &filter, AVERAGE_SAMPLES );
+    for ( i = 0; i < trace->measured.size(); i++ ) {
+        counts = lrintf( trace->measured[i] * (float)MOVING_AVERAGE_FULL_SCALE /
+                         LM35_FULL_SCALE );
+        counts = counts < 0 ? 0 : counts > MOVING_AVERAGE_FULL_SCALE ?
+                 MOVING_AVERAGE_FULL_SCALE : counts;
+        if ( i == 0 ) {
+            movingAverageFill( &filter, (uint16_t)counts );
+        } else {
+            movingAverageUpdate( &filter, (uint16_t)counts );
+        }
+        estimate->push_back( movingAverageReadNormalized( &filter ) *
+                             LM35_FULL_SCALE );
+    }
+}
+
+static void kalmanRun( const trace_t * trace, float processNoise,
+                       std::vector<float> * estimate )
+{
+    kalmanFilter_t filter;
+    size_t i;
+
+    kalmanFilterInit( &filter, processNoise, MEASUREMENT_NOISE,
+                      trace->periodMs );
+    for ( i = 0; i < trace->measured.size(); i++ ) {
+        kalmanFilterUpdate( &filter, trace->measured[i] );
+        estimate->push_back( (float)kalmanFilterValue( &filter ) );
+    }
+}
+
+// @note The lag is the delay of the truth that best matches the estimate
+// once it leaves the steady part; the noise is the RMS error over the
+// second half of the steady part, once the estimators have settled. A
+// recorded trace is taken as a whole for both.
+static result_t resultGet( const trace_t * trace,
+                           const std::vector<float> & estimate )
+{
+    result_t result;
+    size_t start = trace->steadyEnd < trace->measured.size() ?
+                   trace->steadyEnd : 0;
+    size_t noiseStart = start > 0 ? start / 2 : 0;
+    size_t noiseEnd = start > 0 ? start : trace->measured.size();
+    float best = INFINITY;
+    float sum;
+    size_t i;
+    int count;
+    int lag;
+
+    result.lagMs = 0.0f;
+    for ( lag = 0; lag <= MAX_LAG_SAMPLES; lag++ ) {
+        sum = 0.0f;
+        count = 0;
+        for ( i = start + lag; i < trace->measured.size(); i++ ) {
+            if ( !isnan( trace->truth[i - lag] ) ) {
+                sum += powf( estimate[i] - trace->truth[i - lag], 2.0f );
+                count++;
+            }
+        }
+        if ( count > 0 && sum / count < best ) {
+            best = sum / count;
+            result.lagMs = (float)lag * trace->periodMs;
+        }
+    }
+
+    sum = 0.0f;
+    count = 0;
+    for ( i = noiseStart; i < noiseEnd; i++ ) {
+        if ( !isnan( trace->truth[i] ) ) {
+            sum += powf( estimate[i] - trace->truth[i], 2.0f );
+            count++;
+        }
+    }
+    result.noise = count > 0 ? sqrtf( sum / count ) : 0.0f;
+    return result;
+}
+
+//=====[Checks]================================================================
+
+static void traceReport( const trace_t * trace, bool checked )
+{
+    std::vector<float> estimate;
+    result_t average;
+    result_t kalman;
+    unsigned int i;
+
+    averageRun( trace, &estimate );
+    average = resultGet( trace, estimate );
+    printf( "%s, %zu samples every %d ms:\n", trace->name,
+            trace->measured.size(), trace->periodMs );
+    printf( "  %-28s lag %6.0f ms, noise %5.1f\n", "moving average (100)",
+            average.lagMs, average.noise );
+
+    for ( i = 0; i < sizeof( processNoises ) / sizeof( processNoises[0] );
+          i++ ) {
+        estimate.clear();
+        kalmanRun( trace, processNoises[i], &estimate );
+        kalman = resultGet( trace, estimate );
+        printf( "  Kalman, process noise %-6.0f lag %6.0f ms, noise %5.1f\n",
+                processNoises[i], kalman.lagMs, kalman.noise );
+        if ( checked && processNoises[i] == 50.0f ) {
+            check( kalman.lagMs < average.lagMs,
+                   "default tuning lags less than the average" );
+            check( kalman.noise < MEASUREMENT_NOISE,
+                   "default tuning filters the noise" );
+        }
+    }
+}
+
+// @note Readings beyond the Q16.16 range (an LM35 input left open reads
+// about 330 C, 33000 hundredths) must pin the estimate at the limit with the
+// right sign, and it must come back once the readings do.
+static void saturationCheck()
+{
+    kalmanFilter_t filter;
+    int i;
+
+    kalmanFilterInit( &filter, 50.0f, MEASUREMENT_NOISE, PERIOD_MS );
+    kalmanFilterUpdate( &filter, 40000 );
+    check( kalmanFilterValue( &filter ) == KALMAN_FILTER_MEASUREMENT_MAX,
+           "first measurement clamped" );
+    for ( i = 0; i < 1000; i++ ) {
+        kalmanFilterUpdate( &filter, 40000 );
+        check( kalmanFilterValue( &filter ) > 30000, "high estimate stays high" );
+    }
+    for ( i = 0; i < 1000; i++ ) {
+        kalmanFilterUpdate( &filter, i % 2 ? INT32_MAX : INT32_MIN );
+        check( kalmanFilterValue( &filter ) >= -KALMAN_FILTER_MEASUREMENT_MAX &&
+               kalmanFilterValue( &filter ) <= KALMAN_FILTER_MEASUREMENT_MAX,
+               "estimate within range" );
+    }
+    for ( i = 0; i < 5000; i++ ) {
+        kalmanFilterUpdate( &filter, 2500 );
+    }
+    check( abs( kalmanFilterValue( &filter ) - 2500 ) <= 1 &&
+           abs( kalmanFilterRate( &filter ) ) <= 1, "recovers after saturation" );
+}
+
+int main( int argc, char * argv[] )
+{
+    trace_t ramp;
+    int i;
+
+    srand( 1 );
+    rampTraceMake( &ramp );
+    traceReport( &ramp, true );
+
+    for ( i = 1; i < argc; i++ ) {
+        trace_t recorded;
+
+        if ( !recordedTraceLoad( &recorded, argv[i] ) ) {
+            printf( "FAIL: %s is not a trace\n", argv[i] );
+            failures++;
+            continue;
+        }
+        referenceMake( &recorded );
+        traceReport( &recorded, false );
+    }
+
+    saturationCheck();
+
+    if ( failures > 0 ) {
+        printf( "%d failures\n", failures );
+        return 1;
+    }
+    printf( "Kalman estimate lags less than the average and saturates\n" );
+    return 0;
+}
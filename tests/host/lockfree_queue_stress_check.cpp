@@ -0,0 +1,148 @@
+// Stress check and throughput benchmark of SpscQueue and MpscQueue: producer
+// threads and a consumer thread, on different cores when the host has more
+// than one, pass millions of items through queues of several capacities.
+// Every item carries its producer, its sequence number from that producer
+// and a check word, so a lost, repeated, reordered or torn item is detected;
+// MpscQueue keeps the order of each producer, not across producers. The
+// throughput line per run is the benchmark; it is only a comparison between
+// capacities and hosts.
+
+#include "lockfree_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+#define ITEMS_PER_RUN           5000000UL
+#define MPSC_PRODUCERS          3
+
+typedef struct {
+    uint32_t producer;
+    uint32_t sequence;
+    uint32_t check;
+} item_t;
+
+static int failures = 0;
+
+// @note Pins the calling thread to one core, so producer and consumer run in
+// parallel; with a single core they are interleaved by the scheduler, which
+// still preempts them at arbitrary points.
+static void threadPin( int core )
+{
+    cpu_set_t cores;
+    int numberOfCores = std::thread::hardware_concurrency();
+
+    if ( numberOfCores < 2 ) {
+        return;
+    }
+    CPU_ZERO( &cores );
+    CPU_SET( core % numberOfCores, &cores );
+    pthread_setaffinity_np( pthread_self(), sizeof( cores ), &cores );
+}
+
+static uint32_t itemCheck( uint32_t producer, uint32_t sequence )
+{
+    return ~( sequence ^ ( producer << 24 ) ) * 2654435761u;
+}
+
+// @note The items are shared evenly between the producers; the consumer is
+// pinned to the core after the last producer.
+template <typename Queue>
+static void stressRun( const char * name, uint32_t capacity,
+                       uint32_t producers )
+{
+    static Queue queue;
+    uint32_t itemsPerProducer = ITEMS_PER_RUN / producers;
+    std::atomic<unsigned long> fullSpins( 0 );
+    std::vector<std::thread> producerThreads;
+    unsigned long errors = 0;
+    std::chrono::steady_clock::time_point start;
+    double seconds;
+    uint32_t p;
+
+    start = std::chrono::steady_clock::now();
+
+    for ( p = 0; p < producers; p++ ) {
+        producerThreads.emplace_back( [&fullSpins, itemsPerProducer, p]() {
+            item_t item;
+            uint32_t i;
+
+            threadPin( p );
+            item.producer = p;
+            for ( i = 0; i < itemsPerProducer; i++ ) {
+                item.sequence = i;
+                item.check = itemCheck( p, i );
+                while ( !queue.push( item ) ) {
+                    fullSpins.fetch_add( 1, std::memory_order_relaxed );
+                    std::this_thread::yield();
+                }
+            }
+        } );
+    }
+
+    std::thread consumer( [&errors, itemsPerProducer, producers]() {
+        std::vector<uint32_t> expected( producers, 0 );
+        unsigned long received = 0;
+        item_t item;
+
+        threadPin( producers );
+        while ( received < (unsigned long)itemsPerProducer * producers ) {
+            if ( !queue.pop( item ) ) {
+                std::this_thread::yield();
+                continue;
+            }
+            received++;
+            if ( item.producer >= producers ) {
+                errors++;
+                continue;
+            }
+            if ( item.sequence != expected[item.producer] ||
+                 item.check != itemCheck( item.producer, item.sequence ) ) {
+                errors++;
+                expected[item.producer] = item.sequence;
+            }
+            expected[item.producer]++;
+        }
+    } );
+
+    for ( std::thread & producer : producerThreads ) {
+        producer.join();
+    }
+    consumer.join();
+    seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() -
+                                             start ).count();
+
+    if ( errors > 0 || !queue.empty() ) {
+        printf( "FAIL: %s capacity %u, %lu items out of sequence, %u left\n",
+                name, capacity, errors, queue.size() );
+        failures++;
+    }
+    printf( "%s capacity %5u, %u producers: %lu items in %.2f s, "
+            "%.1f Mitems/s, %lu waits on a full queue\n", name, capacity,
+            producers, (unsigned long)itemsPerProducer * producers, seconds,
+            itemsPerProducer * producers / seconds / 1e6, fullSpins.load() );
+}
+
+int main()
+{
+    printf( "%u cores\n", std::thread::hardware_concurrency() );
+    stressRun< SpscQueue<item_t, 2> >( "SPSC", 2, 1 );
+    stressRun< SpscQueue<item_t, 16> >( "SPSC", 16, 1 );
+    stressRun< SpscQueue<item_t, 64> >( "SPSC", 64, 1 );
+    stressRun< SpscQueue<item_t, 1024> >( "SPSC", 1024, 1 );
+    stressRun< MpscQueue<item_t, 2> >( "MPSC", 2, MPSC_PRODUCERS );
+    stressRun< MpscQueue<item_t, 16> >( "MPSC", 16, MPSC_PRODUCERS );
+    stressRun< MpscQueue<item_t, 64> >( "MPSC", 64, MPSC_PRODUCERS );
+    stressRun< MpscQueue<item_t, 1024> >( "MPSC", 1024, MPSC_PRODUCERS );
+
+    if ( failures > 0 ) {
+        printf( "%d failures\n", failures );
+        return 1;
+    }
+    printf( "SPSC and MPSC queues delivered every item once and in order\n" );
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Checks that the integer moving average of raw counts matches the float
+// average the firmware used before (AnalogIn::read() values averaged as
+// floats) within 1 LSB, over random, full-scale and window-change inputs.
+
+#include "moving_average.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int failures = 0;
+
+static void check( bool condition, const char * what, int step )
+{
+    if ( !condition ) {
+        printf( "FAIL: %s at step %d\n", what, step );
+        failures++;
+    }
+}
+
+// Reference: the float average of the last numberOfSamples readings, with
+// the missing ones taken as 0.0 like the original zero-filled array.
+static void compare( movingAverage_t * filter, const uint16_t * history,
+                     int taken, int numberOfSamples, int step )
+{
+    float sum = 0.0f;
+    float floatAverage;
+    int i;
+
+    for ( i = 0; i < numberOfSamples && i < taken; i++ ) {
+        sum += history[taken - 1 - i] / (float)MOVING_AVERAGE_FULL_SCALE;
+    }
+    floatAverage = sum / numberOfSamples;
+
+    check( fabsf( movingAverageReadNormalized( filter ) - floatAverage ) *
+           MOVING_AVERAGE_FULL_SCALE <= 1.0f, "normalized average", step );
+    check( fabsf( movingAverageRead( filter ) -
+                  floatAverage * MOVING_AVERAGE_FULL_SCALE ) <= 1.0f,
+           "average in counts", step );
+}
+
+static void randomInputs( int numberOfSamples, uint16_t ( *next )( int ) )
+{
+    static uint16_t history[10000];
+    movingAverage_t filter;
+    int step;
+
+    movingAverageInit( &filter, numberOfSamples );
+    for ( step = 0; step < 10000; step++ ) {
+        history[step] = next( step );
+        movingAverageUpdate( &filter, history[step] );
+        compare( &filter, history, step + 1, numberOfSamples, step );
+    }
+}
+
+static uint16_t noise( int step )
+{
+    return rand() & 0xFFFF;
+}
+
+static uint16_t fullScale( int step )
+{
+    return ( step / 300 ) % 2 ? MOVING_AVERAGE_FULL_SCALE : 0;
+}
+
+static uint16_t lm35Like( int step )
+{
+    // 25 C on a 12-bit ADC scaled to 16 bits, with +-2 LSB of noise.
+    return ( 496 + rand() % 5 - 2 ) << 4;
+}
+
+// After a window change the average must still match the float average of
+// the latest samples once the new window is full again.
+static void windowChanges()
+{
+    static const int windows[] = { 10, 100, 25, 1, 50 };
+    uint16_t history[2000];
+    movingAverage_t filter;
+    int taken = 0;
+    int w;
+    int i;
+
+    movingAverageInit( &filter, windows[0] );
+    for ( w = 0; w < 5; w++ ) {
+        movingAverageWindowSet( &filter, windows[w] );
+        for ( i = 0; i < 300; i++ ) {
+            history[taken] = rand() & 0xFFFF;
+            movingAverageUpdate( &filter, history[taken] );
+            taken++;
+            if ( movingAverageIsFull( &filter ) ) {
+                compare( &filter, history, taken, windows[w], taken );
+            }
+        }
+    }
+}
+
+// A filled window starts at the first sample, with no variance, and is only
+// full once it holds a window of real samples.
+static void fill()
+{
+    movingAverage_t filter;
+    int i;
+
+    movingAverageInit( &filter, 50 );
+    movingAverageFill( &filter, 496 << 4 );
+    check( movingAverageRead( &filter ) == 496 << 4, "filled average", 0 );
+    check( movingAverageVariance( &filter ) == 0, "filled variance", 0 );
+    for ( i = 1; i < 50; i++ ) {
+        check( !movingAverageIsFull( &filter ), "filled window not full", i );
+        movingAverageUpdate( &filter, 500 << 4 );
+    }
+    check( movingAverageIsFull( &filter ), "filled window full", i );
+    check( movingAverageLastSample( &filter ) == 500 << 4, "last sample", i );
+}
+
+int main()
+{
+    srand( 1 );
+    randomInputs( 100, noise );
+    randomInputs( 7, noise );
+    randomInputs( 100, fullScale );
+    randomInputs( 100, lm35Like );
+    randomInputs( 1, lm35Like );
+    windowChanges();
+    fill();
+
+    if ( failures > 0 ) {
+        printf( "%d failures\n", failures );
+        return 1;
+    }
+    printf( "moving average matches the float average within 1 LSB\n" );
+    return 0;
+}
@@ -0,0 +1,400 @@
+// Broker stand-in check of the MQTT publisher: the module runs on the host
+// socket stand-ins of stubs/ and a minimal MQTT 3.1.1 broker on 127.0.0.1
+// answers CONNECT, PUBLISH and PINGREQ. It checks delivery of alarm events
+// queued during an outage, in order and acknowledged; readings batches;
+// retransmission with DUP while the PUBACK is withheld; the count of alarm
+// events dropped with the queue full; and the socket errors when the broker
+// is missing or no socket can be opened.
+
+#include "mqtt_publisher.h"
+#include "network.h"
+#include "timer_wheel.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define MAX_TICKS               2000
+#define MAX_PUBLISHES           64
+#define RETRY_TICKS             ( 5000 / TIMER_WHEEL_TICK_MS )
+
+typedef struct {
+    char topic[48];
+    char payload[MQTT_PUBLISHER_PAYLOAD_SIZE + 1];
+    int qos;
+    bool duplicate;
+    uint16_t packetId;
+} publish_t;
+
+static NetworkInterface loopback;
+static bool networkUp = true;
+static int failures = 0;
+
+// Broker state
+static int listener = -1;
+static int client = -1;
+static uint8_t rxBuffer[512];
+static int rxLength = 0;
+static bool acknowledge = true;
+static int connects = 0;
+static publish_t publishes[MAX_PUBLISHES];
+static int numberOfPublishes = 0;
+
+//=====[Network module stand-in]===============================================
+
+void networkInit()
+{
+}
+
+void networkUpdate()
+{
+}
+
+bool networkIsUp()
+{
+    return networkUp;
+}
+
+NetworkInterface * networkInterface()
+{
+    return &loopback;
+}
+
+//=====[Broker stand-in]=======================================================
+
+static void check( bool condition, const char * what )
+{
+    if ( !condition ) {
+        printf( "FAIL: %s (tick %lu)\n", what, (unsigned long)timerWheelTicks() );
+        failures++;
+    }
+}
+
+static void brokerStart()
+{
+    struct sockaddr_in address;
+    int reuse = 1;
+
+    listener = socket( AF_INET, SOCK_STREAM, 0 );
+    setsockopt( listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof( reuse ) );
+    memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_port = htons( MBED_CONF_APP_MQTT_BROKER_PORT );
+    inet_pton( AF_INET, "127.0.0.1", &address.sin_addr );
+    check( bind( listener, (struct sockaddr *)&address, sizeof( address ) ) == 0,
+           "broker port free" );
+    listen( listener, 1 );
+    fcntl( listener, F_SETFL, O_NONBLOCK );
+}
+
+static void brokerClientClose()
+{
+    if ( client >= 0 ) {
+        close( client );
+        client = -1;
+    }
+    rxLength = 0;
+}
+
+static void brokerSend( const uint8_t * packet, int length )
+{
+    check( send( client, packet, length, MSG_NOSIGNAL ) == length,
+           "broker send" );
+}
+
+static void packetProcess( const uint8_t * packet, int headerLength,
+                           int remainingLength )
+{
+    static const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    static const uint8_t pingresp[] = { 0xD0, 0x00 };
+    const uint8_t * body = packet + headerLength;
+    publish_t * publish;
+    uint8_t puback[4] = { 0x40, 0x02, 0, 0 };
+    int topicLength;
+    int position;
+
+    switch ( packet[0] & 0xF0 ) {
+    case 0x10:
+        check( body[0] == 0 && body[1] == 4 && !memcmp( body + 2, "MQTT", 4 ),
+               "CONNECT protocol name" );
+        check( body[6] == 4, "CONNECT protocol level" );
+        connects++;
+        brokerSend( connack, sizeof( connack ) );
+        break;
+
+    case 0x30:
+        check( numberOfPublishes < MAX_PUBLISHES, "publish log room" );
+        publish = &publishes[numberOfPublishes % MAX_PUBLISHES];
+        numberOfPublishes++;
+        publish->qos = ( packet[0] >> 1 ) & 0x03;
+        publish->duplicate = ( packet[0] & 0x08 ) != 0;
+        topicLength = ( body[0] << 8 ) | body[1];
+        memcpy( publish->topic, body + 2, topicLength );
+        publish->topic[topicLength] = '\0';
+        position = 2 + topicLength;
+        publish->packetId = 0;
+        if ( publish->qos > 0 ) {
+            publish->packetId = ( body[position] << 8 ) | body[position + 1];
+            position += 2;
+        }
+        memcpy( publish->payload, body + position, remainingLength - position );
+        publish->payload[remainingLength - position] = '\0';
+        if ( publish->qos == 1 && acknowledge ) {
+            puback[2] = publish->packetId >> 8;
+            puback[3] = publish->packetId & 0xFF;
+            brokerSend( puback, sizeof( puback ) );
+        }
+        break;
+
+    case 0xC0:
+        brokerSend( pingresp, sizeof( pingresp ) );
+        break;
+
+    default:
+        check( false, "packet type sent by a publisher" );
+        break;
+    }
+}
+
+// @note Accepts the publisher and handles every whole packet received.
+static void brokerService()
+{
+    ssize_t received;
+    int remainingLength;
+    int multiplier;
+    int headerLength;
+
+    if ( listener < 0 ) {
+        return;
+    }
+    if ( client < 0 ) {
+        client = accept( listener, NULL, NULL );
+        if ( client < 0 ) {
+            return;
+        }
+        fcntl( client, F_SETFL, O_NONBLOCK );
+    }
+
+    received = recv( client, rxBuffer + rxLength, sizeof( rxBuffer ) - rxLength,
+                     0 );
+    if ( received == 0 || ( received < 0 && errno != EAGAIN ) ) {
+        brokerClientClose();
+        return;
+    }
+    if ( received > 0 ) {
+        rxLength += received;
+    }
+
+    while ( rxLength >= 2 ) {
+        remainingLength = 0;
+        multiplier = 1;
+        headerLength = 1;
+        do {
+            remainingLength += ( rxBuffer[headerLength] & 0x7F ) * multiplier;
+            multiplier *= 128;
+        } while ( rxBuffer[headerLength++] & 0x80 && headerLength < rxLength );
+        if ( rxLength < headerLength + remainingLength ) {
+            break;
+        }
+        packetProcess( rxBuffer, headerLength, remainingLength );
+        rxLength -= headerLength + remainingLength;
+        memmove( rxBuffer, rxBuffer + headerLength + remainingLength, rxLength );
+    }
+}
+
+//=====[Check helpers]=========================================================
+
+static void tick()
+{
+    timerWheelUpdate();
+    mqttPublisherUpdate();
+    brokerService();
+}
+
+static bool ticksUntil( bool ( *condition )() )
+{
+    int i;
+
+    for ( i = 0; i < MAX_TICKS && !condition(); i++ ) {
+        tick();
+    }
+    return condition();
+}
+
+static bool queueEmpty()
+{
+    mqttPublisherStats_t stats;
+
+    mqttPublisherStatsGet( &stats );
+    return stats.queued == 0 && mqttPublisherIsConnected();
+}
+
+static void alarmEventsPublish( int first, int count )
+{
+    char payload[32];
+    int i;
+
+    for ( i = first; i < first + count; i++ ) {
+        sprintf( payload, "{\"event\":%d}", i );
+        mqttPublisherAlarmEventPublish( payload );
+    }
+}
+
+// @note Checks that the alarm events first..last reached the broker once,
+// in order, starting at publish number start.
+static void alarmEventsCheck( int start, int first, int last )
+{
+    char payload[32];
+    int i;
+
+    check( numberOfPublishes - start == last - first + 1,
+           "number of alarm events delivered" );
+    for ( i = first; i <= last && start + i - first < numberOfPublishes; i++ ) {
+        sprintf( payload, "{\"event\":%d}", i );
+        check( !strcmp( publishes[start + i - first].payload, payload ),
+               "alarm event order" );
+        check( !strcmp( publishes[start + i - first].topic, "test/alarm/alarm" ),
+               "alarm topic" );
+        check( publishes[start + i - first].qos == 1, "alarm QoS 1" );
+    }
+}
+
+//=====[Checks]================================================================
+
+static void brokerMissing()
+{
+    mqttPublisherStats_t stats;
+    int i;
+
+    alarmEventsPublish( 0, 3 );
+    for ( i = 0; i < 10; i++ ) {
+        tick();
+    }
+    mqttPublisherStatsGet( &stats );
+    check( !mqttPublisherIsConnected(), "not connected without a broker" );
+    check( stats.socketError == NSAPI_ERROR_NO_CONNECTION,
+           "refused connection reported" );
+    check( stats.queued == 3, "events kept while the broker is missing" );
+
+    brokerStart();
+    check( ticksUntil( queueEmpty ), "queued events delivered" );
+    mqttPublisherStatsGet( &stats );
+    check( stats.socketError == NSAPI_ERROR_OK, "socket error cleared" );
+    check( stats.acknowledged == 3, "queued events acknowledged" );
+    check( connects == 1, "one connection" );
+    alarmEventsCheck( 0, 0, 2 );
+}
+
+static void readings()
+{
+    int start = numberOfPublishes;
+    int i;
+
+    for ( i = 0; i < 2 * MQTT_PUBLISHER_BATCH_SIZE + 3; i++ ) {
+        mqttPublisherReadingAdd( 1000 * i, 2500 + i );
+    }
+    ticksUntil( queueEmpty );
+    check( numberOfPublishes - start == 2, "two readings batches" );
+    check( !strcmp( publishes[start].topic, "test/alarm/temperature" ),
+           "readings topic" );
+    check( publishes[start].qos == 0, "readings QoS 0" );
+    check( !strcmp( publishes[start].payload, "{\"ms\":0,\"c\":[2500,2501,2502,"
+                    "2503,2504,2505,2506,2507,2508,2509]}" ),
+           "first readings batch" );
+    check( !strncmp( publishes[start + 1].payload, "{\"ms\":10000,\"c\":[2510,",
+                     strlen( "{\"ms\":10000,\"c\":[2510," ) ),
+           "second readings batch" );
+}
+
+static void retransmission()
+{
+    mqttPublisherStats_t stats;
+    int start = numberOfPublishes;
+    int i;
+
+    acknowledge = false;
+    alarmEventsPublish( 100, 1 );
+    for ( i = 0; i < MAX_TICKS && numberOfPublishes == start; i++ ) {
+        tick();
+    }
+    acknowledge = true;
+    check( ticksUntil( queueEmpty ), "retransmitted event acknowledged" );
+    mqttPublisherStatsGet( &stats );
+    check( numberOfPublishes - start == 2, "sent twice" );
+    check( !publishes[start].duplicate && publishes[start + 1].duplicate,
+           "DUP only on the retransmission" );
+    check( publishes[start].packetId == publishes[start + 1].packetId,
+           "same packet identifier" );
+    check( stats.retransmitted == 1, "retransmission counted" );
+}
+
+static void queueFull()
+{
+    mqttPublisherStats_t stats;
+    int start;
+
+    networkUp = false;
+    tick();
+    check( !mqttPublisherIsConnected(), "disconnected with the network down" );
+    start = numberOfPublishes;
+
+    alarmEventsPublish( 200, MQTT_PUBLISHER_QUEUE_SIZE + 4 );
+    mqttPublisherStatsGet( &stats );
+    check( stats.alarmEventsDropped == 4, "alarm events dropped counted" );
+    check( stats.queued == MQTT_PUBLISHER_QUEUE_SIZE, "queue full" );
+
+    networkUp = true;
+    check( ticksUntil( queueEmpty ), "latest events delivered" );
+    alarmEventsCheck( start, 204, 204 + MQTT_PUBLISHER_QUEUE_SIZE - 1 );
+}
+
+static void openFailure()
+{
+    mqttPublisherStats_t stats;
+    int i;
+
+    networkUp = false;
+    tick();
+    hostSocketOpenError = NSAPI_ERROR_NO_SOCKET;
+    networkUp = true;
+    alarmEventsPublish( 300, 1 );
+    for ( i = 0; i < RETRY_TICKS + 10; i++ ) {
+        tick();
+    }
+    mqttPublisherStatsGet( &stats );
+    check( !mqttPublisherIsConnected(), "not connected without a socket" );
+    check( stats.socketError == NSAPI_ERROR_NO_SOCKET, "open error reported" );
+
+    hostSocketOpenError = NSAPI_ERROR_OK;
+    check( ticksUntil( queueEmpty ), "connected once a socket is free" );
+}
+
+int main()
+{
+    mqttPublisherStats_t stats;
+
+    timerWheelInit();
+    mqttPublisherInit();
+
+    brokerMissing();
+    readings();
+    retransmission();
+    queueFull();
+    openFailure();
+
+    mqttPublisherStatsGet( &stats );
+    if ( failures > 0 ) {
+        printf( "%d failures\n", failures );
+        return 1;
+    }
+    printf( "MQTT publisher: %lu published, %lu acknowledged, %lu "
+            "retransmitted, %lu alarm events dropped, %d connections\n",
+            (unsigned long)stats.published, (unsigned long)stats.acknowledged,
+            (unsigned long)stats.retransmitted,
+            (unsigned long)stats.alarmEventsDropped, connects );
+    return 0;
+}
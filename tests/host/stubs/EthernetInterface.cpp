@@ -0,0 +1,218 @@
+#include "EthernetInterface.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+nsapi_error_t hostSocketOpenError = NSAPI_ERROR_OK;
+
+static nsapi_error_t errorFromErrno()
+{
+    switch ( errno ) {
+    case EAGAIN:
+        return NSAPI_ERROR_WOULD_BLOCK;
+    case EINPROGRESS:
+        return NSAPI_ERROR_IN_PROGRESS;
+    case EALREADY:
+        return NSAPI_ERROR_ALREADY;
+    case EISCONN:
+        return NSAPI_ERROR_IS_CONNECTED;
+    case EADDRINUSE:
+    case EINVAL:
+        return NSAPI_ERROR_PARAMETER;
+    case ECONNREFUSED:
+    case ECONNRESET:
+    case ENOTCONN:
+    case EPIPE:
+        return NSAPI_ERROR_NO_CONNECTION;
+    default:
+        return NSAPI_ERROR_DEVICE_ERROR;
+    }
+}
+
+static struct sockaddr_in posixAddress( const SocketAddress & address )
+{
+    struct sockaddr_in posix;
+
+    memset( &posix, 0, sizeof( posix ) );
+    posix.sin_family = AF_INET;
+    posix.sin_addr.s_addr = address.ip;
+    posix.sin_port = htons( address.port );
+    return posix;
+}
+
+SocketAddress::SocketAddress() : ip( 0 ), port( 0 )
+{
+}
+
+bool SocketAddress::set_ip_address( const char * address )
+{
+    struct in_addr parsed;
+
+    if ( inet_pton( AF_INET, address, &parsed ) != 1 ) {
+        return false;
+    }
+    ip = parsed.s_addr;
+    return true;
+}
+
+void SocketAddress::set_port( uint16_t newPort )
+{
+    port = newPort;
+}
+
+uint16_t SocketAddress::get_port() const
+{
+    return port;
+}
+
+Socket::Socket( int type ) : type( type ), fd( -1 ), blocking( true )
+{
+}
+
+Socket::~Socket()
+{
+    close();
+}
+
+nsapi_error_t Socket::open( NetworkInterface * stack )
+{
+    int noDelay = 1;
+
+    if ( hostSocketOpenError != NSAPI_ERROR_OK ) {
+        return hostSocketOpenError;
+    }
+    if ( fd >= 0 ) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+    fd = socket( AF_INET, type, 0 );
+    if ( fd < 0 ) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+    // The checks tick much faster than real time, so a segment held back by
+    // the Nagle algorithm would only leave after many ticks.
+    if ( type == SOCK_STREAM ) {
+        setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof( noDelay ) );
+    }
+    set_blocking( blocking );
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t Socket::close()
+{
+    if ( fd < 0 ) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+    ::close( fd );
+    fd = -1;
+    return NSAPI_ERROR_OK;
+}
+
+void Socket::set_blocking( bool enable )
+{
+    blocking = enable;
+    if ( fd >= 0 ) {
+        fcntl( fd, F_SETFL, enable ? 0 : O_NONBLOCK );
+    }
+}
+
+UDPSocket::UDPSocket() : Socket( SOCK_DGRAM )
+{
+}
+
+nsapi_error_t UDPSocket::bind( uint16_t port )
+{
+    SocketAddress local;
+    struct sockaddr_in posix;
+
+    if ( fd < 0 ) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+    local.set_ip_address( "127.0.0.1" );
+    local.set_port( port );
+    posix = posixAddress( local );
+    if ( ::bind( fd, (struct sockaddr *)&posix, sizeof( posix ) ) != 0 ) {
+        return errorFromErrno();
+    }
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_size_or_error_t UDPSocket::sendto( const SocketAddress & address,
+                                         const void * data, nsapi_size_t size )
+{
+    struct sockaddr_in posix = posixAddress( address );
+    ssize_t sent;
+
+    if ( fd < 0 ) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+    sent = ::sendto( fd, data, size, 0, (struct sockaddr *)&posix,
+                     sizeof( posix ) );
+    return sent < 0 ? errorFromErrno() : (nsapi_size_or_error_t)sent;
+}
+
+nsapi_size_or_error_t UDPSocket::recvfrom( SocketAddress * address,
+                                           void * data, nsapi_size_t size )
+{
+    struct sockaddr_in posix;
+    socklen_t length = sizeof( posix );
+    ssize_t received;
+
+    if ( fd < 0 ) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+    received = ::recvfrom( fd, data, size, 0, (struct sockaddr *)&posix,
+                           &length );
+    if ( received < 0 ) {
+        return errorFromErrno();
+    }
+    if ( address != NULL ) {
+        address->ip = posix.sin_addr.s_addr;
+        address->port = ntohs( posix.sin_port );
+    }
+    return received;
+}
+
+TCPSocket::TCPSocket() : Socket( SOCK_STREAM )
+{
+}
+
+nsapi_error_t TCPSocket::connect( const SocketAddress & address )
+{
+    struct sockaddr_in posix = posixAddress( address );
+
+    if ( fd < 0 ) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+    if ( ::connect( fd, (struct sockaddr *)&posix, sizeof( posix ) ) != 0 ) {
+        return errorFromErrno();
+    }
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_size_or_error_t TCPSocket::send( const void * data, nsapi_size_t size )
+{
+    ssize_t sent;
+
+    if ( fd < 0 ) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+    sent = ::send( fd, data, size, MSG_NOSIGNAL );
+    return sent < 0 ? errorFromErrno() : (nsapi_size_or_error_t)sent;
+}
+
+nsapi_size_or_error_t TCPSocket::recv( void * data, nsapi_size_t size )
+{
+    ssize_t received;
+
+    if ( fd < 0 ) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+    received = ::recv( fd, data, size, 0 );
+    return received < 0 ? errorFromErrno() : (nsapi_size_or_error_t)received;
+}
@@ -0,0 +1,80 @@
+// Stand-in for the mbed socket API on top of POSIX sockets (implemented in
+// EthernetInterface.cpp, which keeps the POSIX names out of the modules), so
+// the network modules can be checked against real peers on the loopback
+// interface. Only the calls the modules make are provided, with the mbed
+// return conventions (NSAPI_ERROR_* codes, WOULD_BLOCK in non-blocking mode).
+
+#ifndef _ETHERNET_INTERFACE_H_
+#define _ETHERNET_INTERFACE_H_
+
+#include <stdint.h>
+
+typedef int nsapi_error_t;
+typedef int nsapi_size_or_error_t;
+typedef unsigned int nsapi_size_t;
+
+#define NSAPI_ERROR_OK                       0
+#define NSAPI_ERROR_WOULD_BLOCK          -3001
+#define NSAPI_ERROR_PARAMETER            -3003
+#define NSAPI_ERROR_NO_CONNECTION        -3004
+#define NSAPI_ERROR_NO_SOCKET            -3005
+#define NSAPI_ERROR_DEVICE_ERROR         -3012
+#define NSAPI_ERROR_IN_PROGRESS          -3013
+#define NSAPI_ERROR_ALREADY              -3014
+#define NSAPI_ERROR_IS_CONNECTED         -3015
+#define NSAPI_ERROR_CONNECTION_TIMEOUT   -3017
+
+// Error returned by the next Socket::open() calls, to check how a module
+// copes with a stack out of sockets; NSAPI_ERROR_OK opens normally.
+extern nsapi_error_t hostSocketOpenError;
+
+class NetworkInterface {
+};
+
+class SocketAddress {
+public:
+    SocketAddress();
+    bool set_ip_address( const char * ip );
+    void set_port( uint16_t port );
+    uint16_t get_port() const;
+
+    uint32_t ip;
+    uint16_t port;
+};
+
+class Socket {
+public:
+    explicit Socket( int type );
+    ~Socket();
+
+    nsapi_error_t open( NetworkInterface * stack );
+    nsapi_error_t close();
+    void set_blocking( bool enable );
+
+protected:
+    int type;
+    int fd;
+    bool blocking;
+};
+
+class UDPSocket : public Socket {
+public:
+    UDPSocket();
+
+    nsapi_error_t bind( uint16_t port );
+    nsapi_size_or_error_t sendto( const SocketAddress & address,
+                                  const void * data, nsapi_size_t size );
+    nsapi_size_or_error_t recvfrom( SocketAddress * address, void * data,
+                                    nsapi_size_t size );
+};
+
+class TCPSocket : public Socket {
+public:
+    TCPSocket();
+
+    nsapi_error_t connect( const SocketAddress & address );
+    nsapi_size_or_error_t send( const void * data, nsapi_size_t size );
+    nsapi_size_or_error_t recv( void * data, nsapi_size_t size );
+};
+
+#endif // _ETHERNET_INTERFACE_H_
@@ -0,0 +1,217 @@
+// Loopback check of the UDP endpoint: the module runs on the host socket
+// stand-ins of stubs/ and a peer on 127.0.0.1 plays the monitoring host. It
+// queries the status, receives the telemetry pushes, and checks that a
+// socket that cannot be opened or bound is reported by udpEndpointError()
+// and opened again after the retry time.
+
+#include "network.h"
+#include "timer_wheel.h"
+#include "udp_endpoint.h"
+
+#include <stdio.h>
+
+#define MAX_TICKS               1000
+
+static NetworkInterface loopback;
+static bool networkUp = true;
+static int failures = 0;
+static uint32_t reportsRead = 0;
+
+//=====[Network module stand-in]===============================================
+
+void networkInit()
+{
+}
+
+void networkUpdate()
+{
+}
+
+bool networkIsUp()
+{
+    return networkUp;
+}
+
+NetworkInterface * networkInterface()
+{
+    return &loopback;
+}
+
+//=====[Check helpers]=========================================================
+
+static void check( bool condition, const char * what )
+{
+    if ( !condition ) {
+        printf( "FAIL: %s\n", what );
+        failures++;
+    }
+}
+
+static void statusReportGet( statusReport_t * report )
+{
+    memset( report, 0, sizeof( *report ) );
+    report->uptimeMs = timerWheelTicks() * TIMER_WHEEL_TICK_MS;
+    report->votedTempCentiC = 2512;
+    reportsRead++;
+}
+
+static void tick()
+{
+    timerWheelUpdate();
+    udpEndpointUpdate();
+}
+
+// @note Ticks the endpoint until the peer receives a datagram, as the
+// control loop would; returns its length, or 0 if none arrives.
+static int receive( UDPSocket * peer, uint8_t * frame, int size )
+{
+    SocketAddress from;
+    int received;
+    int i;
+
+    for ( i = 0; i < MAX_TICKS; i++ ) {
+        tick();
+        received = peer->recvfrom( &from, frame, size );
+        if ( received > 0 ) {
+            return received;
+        }
+    }
+    return 0;
+}
+
+static bool frameIsStatus( const uint8_t * frame, int length )
+{
+    return length == STATUS_REPORT_ENCODED_SIZE &&
+           frame[0] == STATUS_REPORT_MAGIC &&
+           frame[1] == STATUS_REPORT_VERSION &&
+           ( frame[14] | ( frame[15] << 8 ) ) == 2512;
+}
+
+static uint16_t frameSequence( const uint8_t * frame )
+{
+    return frame[2] | ( frame[3] << 8 );
+}
+
+//=====[Checks]================================================================
+
+static void queries( UDPSocket * peer )
+{
+    SocketAddress endpoint;
+    uint8_t frame[64];
+    uint16_t previousSequence = 0;
+    int length;
+    int i;
+
+    endpoint.set_ip_address( "127.0.0.1" );
+    endpoint.set_port( MBED_CONF_APP_UDP_PORT );
+
+    for ( i = 0; i < 20; i++ ) {
+        peer->sendto( endpoint, "S", 1 );
+        length = receive( peer, frame, sizeof( frame ) );
+        check( frameIsStatus( frame, length ), "status frame" );
+        if ( i > 0 ) {
+            check( frameSequence( frame ) == (uint16_t)( previousSequence + 1 ),
+                   "sequence increments per frame" );
+        }
+        previousSequence = frameSequence( frame );
+    }
+
+    peer->sendto( endpoint, "X", 1 );
+    for ( i = 0; i < 10; i++ ) {
+        tick();
+    }
+    check( peer->recvfrom( &endpoint, frame, sizeof( frame ) ) ==
+           NSAPI_ERROR_WOULD_BLOCK, "unknown query not answered" );
+}
+
+static void telemetry( UDPSocket * peer )
+{
+    SocketAddress from;
+    uint8_t frame[64];
+    uint32_t firstTick;
+    int length;
+
+    while ( peer->recvfrom( &from, frame, sizeof( frame ) ) > 0 ) {
+    }
+    receive( peer, frame, sizeof( frame ) );
+    firstTick = timerWheelTicks();
+    length = receive( peer, frame, sizeof( frame ) );
+    check( frameIsStatus( frame, length ), "telemetry frame" );
+    check( ( timerWheelTicks() - firstTick ) * TIMER_WHEEL_TICK_MS ==
+           MBED_CONF_APP_UDP_TELEMETRY_PERIOD_MS, "telemetry period" );
+}
+
+static void openFailures()
+{
+    UDPSocket squatter;
+    uint32_t failedTick;
+    int i;
+
+    networkUp = false;
+    tick();
+    check( !udpEndpointIsConnected(), "closed while the network is down" );
+
+    // Out of sockets: reported, and tried again after the retry time.
+    hostSocketOpenError = NSAPI_ERROR_NO_SOCKET;
+    networkUp = true;
+    tick();
+    check( !udpEndpointIsConnected(), "not open without a socket" );
+    check( udpEndpointError() == NSAPI_ERROR_NO_SOCKET, "open error reported" );
+    hostSocketOpenError = NSAPI_ERROR_OK;
+
+    // Port taken by another socket: bind fails, reported the same way.
+    squatter.open( &loopback );
+    check( squatter.bind( MBED_CONF_APP_UDP_PORT ) == NSAPI_ERROR_OK,
+           "squatter bound" );
+    failedTick = timerWheelTicks();
+    for ( i = 0; i < MAX_TICKS && udpEndpointError() != NSAPI_ERROR_PARAMETER;
+          i++ ) {
+        tick();
+    }
+    check( udpEndpointError() == NSAPI_ERROR_PARAMETER, "bind error reported" );
+    check( ( timerWheelTicks() - failedTick ) * TIMER_WHEEL_TICK_MS >=
+           NETWORK_CONNECT_RETRY_TIME, "retry waits" );
+    check( !udpEndpointIsConnected(), "not open without the port" );
+
+    squatter.close();
+    for ( i = 0; i < MAX_TICKS && !udpEndpointIsConnected(); i++ ) {
+        tick();
+    }
+    check( udpEndpointIsConnected(), "open once the port is free" );
+    check( udpEndpointError() == NSAPI_ERROR_OK, "error cleared" );
+}
+
+// @note The monitoring host queries from an ephemeral port and receives the
+// telemetry on another socket, bound to the telemetry port.
+int main()
+{
+    UDPSocket queryPeer;
+    UDPSocket telemetryPeer;
+
+    timerWheelInit();
+    udpEndpointInit( statusReportGet );
+
+    queryPeer.open( &loopback );
+    queryPeer.set_blocking( false );
+    telemetryPeer.open( &loopback );
+    check( telemetryPeer.bind( MBED_CONF_APP_UDP_TELEMETRY_PORT ) ==
+           NSAPI_ERROR_OK, "telemetry port free" );
+    telemetryPeer.set_blocking( false );
+
+    tick();
+    check( udpEndpointIsConnected(), "open with the network up" );
+    check( udpEndpointError() == NSAPI_ERROR_OK, "no socket error" );
+
+    queries( &queryPeer );
+    telemetry( &telemetryPeer );
+    openFailures();
+    queries( &queryPeer );
+
+    if ( failures > 0 ) {
+        printf( "%d failures\n", failures );
+        return 1;
+    }
+    printf( "UDP endpoint answered, pushed telemetry and reported socket "
+            "errors (%lu reports)\n", (unsigned long)reportsRead );
+    return 0;
+}
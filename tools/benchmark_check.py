@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Compares benchmark counts against a baseline.
+
+Usage:
+    python3 tools/benchmark_check.py benchmark.json baseline.json
+        [--tolerance 5] [--update]
+
+Both files are written by tools/benchmark_run.py. The mean count of every
+function in the baseline is compared with the new one; the script exits
+with status 1 when any of them grew by more than the tolerance (in percent)
+or is missing from the results, so it can gate a merge. Functions that are
+new or got faster are only listed. --update copies the results over the
+baseline after a change that is expected to cost more.
+"""
+
+import argparse
+import json
+import shutil
+import sys
+
+
+def load(path):
+    with open(path, encoding='utf-8') as results_file:
+        return json.load(results_file)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('results')
+    parser.add_argument('baseline')
+    parser.add_argument('--tolerance', type=float, default=5.0,
+                        help='largest allowed increase of the mean, in percent')
+    parser.add_argument('--update', action='store_true',
+                        help='replace the baseline with the results')
+    args = parser.parse_args()
+
+    if args.update:
+        shutil.copyfile(args.results, args.baseline)
+        print('Baseline %s updated' % args.baseline)
+        return 0
+
+    results = load(args.results)
+    baseline = load(args.baseline)
+    failed = False
+
+    print('%-24s %10s %10s %8s' % ('Function', 'Baseline', 'Mean', 'Change'))
+    for name in sorted(set(baseline) | set(results)):
+        if name not in results:
+            print('%-24s %10d %10s %8s  MISSING' % (name, baseline[name]['mean'],
+                                                   '-', '-'))
+            failed = True
+            continue
+        mean = results[name]['mean']
+        if name not in baseline:
+            print('%-24s %10s %10d %8s  NEW' % (name, '-', mean, '-'))
+            continue
+        reference = baseline[name]['mean']
+        if reference:
+            change = 100.0 * (mean - reference) / reference
+        else:
+            change = 0.0 if mean == 0 else float('inf')
+        status = ''
+        if change > args.tolerance:
+            status = '  REGRESSION'
+            failed = True
+        print('%-24s %10d %10d %+7.1f%%%s' % (name, reference, mean, change,
+                                              status))
+
+    print()
+    print('Tolerance %.1f%%: %s' % (args.tolerance,
+                                   'FAILED' if failed else 'OK'))
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
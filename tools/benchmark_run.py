@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Runs the firmware benchmark mode under Renode and collects the counts.
+
+Usage:
+    python3 tools/benchmark_run.py BUILD/NUCLEO_F429ZI/GCC_ARM/<project>.elf
+        [--output benchmark.json] [--renode renode] [--timeout 300]
+
+The firmware must be built with the "benchmark", "virtual-clock" and
+"simulated-inputs-seed" options set in mbed_app.json, for instance:
+
+    "benchmark": true, "virtual-clock": true, "simulated-inputs-seed": 1
+
+so that it needs no physical inputs and prints one
+"BENCH,name,iterations,min,mean,max" line per function, then "BENCH,END".
+The counts are instructions under Renode (see tools/renode/nucleo_f429zi.resc)
+and CPU cycles when the same firmware runs on a board.
+
+The results are printed as a table and written as JSON, to be compared
+against a baseline by tools/benchmark_check.py. QEMU is not supported: it
+does not emulate the DWT cycle counter, which reads 0 there.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+SCRIPT = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                      'renode', 'nucleo_f429zi.resc')
+POLL_TIME = 0.5
+
+
+def parse_results(text):
+    """Returns {name: {iterations, min, mean, max}} and whether the end
+    marker was seen."""
+    results = {}
+    finished = False
+    for line in text.splitlines():
+        fields = line.strip().split(',')
+        if fields[0] != 'BENCH':
+            continue
+        if len(fields) >= 2 and fields[1] == 'END':
+            finished = True
+            break
+        if len(fields) != 6:
+            continue
+        try:
+            counts = [int(field) for field in fields[2:]]
+        except ValueError:
+            continue
+        results[fields[1]] = dict(zip(('iterations', 'min', 'mean', 'max'),
+                                      counts))
+    return results, finished
+
+
+def run_renode(renode, elf, timeout):
+    """Runs the script until the firmware prints the end marker and returns
+    the console output."""
+    with tempfile.TemporaryDirectory() as directory:
+        log = os.path.join(directory, 'console.txt')
+        commands = ('$bin=@%s; $log=@%s; include @%s; start'
+                    % (os.path.abspath(elf), log, SCRIPT))
+        process = subprocess.Popen([renode, '--disable-xwt', '--console',
+                                    '--plain', '-e', commands],
+                                   stdin=subprocess.DEVNULL,
+                                   stdout=subprocess.DEVNULL,
+                                   stderr=subprocess.STDOUT)
+        text = ''
+        deadline = time.monotonic() + timeout
+        try:
+            while time.monotonic() < deadline:
+                if process.poll() is not None:
+                    break
+                if os.path.exists(log):
+                    with open(log, encoding='latin-1') as log_file:
+                        text = log_file.read()
+                    if parse_results(text)[1]:
+                        break
+                time.sleep(POLL_TIME)
+        finally:
+            process.kill()
+            process.wait()
+            if os.path.exists(log):
+                with open(log, encoding='latin-1') as log_file:
+                    text = log_file.read()
+    return text
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('elf_file')
+    parser.add_argument('--output', default='benchmark.json',
+                        help='JSON file receiving the results')
+    parser.add_argument('--renode', default='renode',
+                        help='Renode executable')
+    parser.add_argument('--timeout', type=float, default=300,
+                        help='seconds to wait for the end of the benchmark')
+    args = parser.parse_args()
+
+    try:
+        text = run_renode(args.renode, args.elf_file, args.timeout)
+    except OSError as error:
+        print('Cannot run %s: %s' % (args.renode, error), file=sys.stderr)
+        return 2
+
+    results, finished = parse_results(text)
+    if not finished:
+        print('The benchmark did not finish within %g s; is the firmware '
+              'built with "benchmark" enabled?' % args.timeout,
+              file=sys.stderr)
+        return 2
+
+    print('%-24s %10s %10s %10s %10s' % ('Function', 'Iterations', 'Min',
+                                         'Mean', 'Max'))
+    for name, counts in results.items():
+        print('%-24s %10d %10d %10d %10d' % (name, counts['iterations'],
+                                             counts['min'], counts['mean'],
+                                             counts['max']))
+
+    with open(args.output, 'w', encoding='utf-8') as output:
+        json.dump(results, output, indent=2, sort_keys=True)
+        output.write('\n')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""Per-module and per-symbol RAM/flash report from a GCC_ARM linker map file.
+
+Usage:
+    python3 tools/memory_report.py BUILD/NUCLEO_F429ZI/GCC_ARM/<project>.map
+        [--symbols N] [--config mbed_app.json] [--update-budgets PERCENT]
+
+The budgets are read from the "flash-budget-bytes" and "ram-budget-bytes"
+entries of the "config" section of mbed_app.json. The script exits with
+status 1 when any of them is exceeded or missing; the CI workflow
+(.github/workflows/firmware.yml) runs it right after the compile step, so
+an overrun fails the build.
+
+--update-budgets sets both budgets to the sizes of this build plus PERCENT
+of headroom, rounded up to 1 KB, and writes them to mbed_app.json; run it
+on a release build to take the budgets from a measured build.
+
+Flash counts everything loaded into flash (code, read-only data, exception
+tables and the initial values of .data). RAM counts the statically
+allocated memory (.data, .bss and .uninitialized); the heap and the stack
+reservations are excluded because they take whatever RAM is left.
+"""
+
+import argparse
+import collections
+import json
+import os
+import re
+import sys
+
+FLASH_SECTIONS = ('.text', '.rodata', '.ARM.extab', '.ARM.exidx', '.data',
+                  '.isr_vector', '.init_array', '.fini_array', '.copy.table',
+                  '.zero.table')
+RAM_SECTIONS = ('.data', '.bss', '.uninitialized')
+
+OUTPUT_SECTION_RE = re.compile(r'^(\.[\w.]+)\s*(0x[0-9a-fA-F]+)?')
+INPUT_SECTION_RE = re.compile(r'^ (\S+)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(.+)$')
+INPUT_SECTION_NAME_RE = re.compile(r'^ (\S+)$')
+INPUT_SECTION_CONT_RE = re.compile(r'^\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(.+)$')
+SYMBOL_RE = re.compile(r'^\s+0x[0-9a-fA-F]+\s+([^=\s].*)$')
+
+
+def module_of(object_path):
+    """Groups an object file into a module: mbed-os/<component>, the
+    directory of an application module, or the library archive name."""
+    path = object_path.replace('\\', '/')
+    archive = re.match(r'(.*/)?([^/]+\.a)\(', path)
+    if archive:
+        return archive.group(2)
+    path = re.sub(r'^(\./)?BUILD/[^/]+/[^/]+/', '', path)
+    parts = [p for p in path.split('/') if p not in ('', '.')]
+    if parts and parts[0] == 'mbed-os':
+        return '/'.join(parts[:2])
+    if len(parts) > 1:
+        return '/'.join(parts[:-1])
+    return os.path.splitext(parts[0])[0] if parts else '?'
+
+
+def symbol_of(section_name, following_symbol):
+    if following_symbol:
+        return following_symbol
+    for prefix in ('.text.', '.rodata.', '.data.', '.bss.'):
+        if section_name.startswith(prefix):
+            return section_name[len(prefix):]
+    return section_name
+
+
+def parse_map(path):
+    """Returns a list of (output section, module, symbol, size) tuples."""
+    entries = []
+    output_section = None
+    pending_name = None
+    last = None
+
+    with open(path, encoding='utf-8', errors='replace') as map_file:
+        lines = iter(map_file)
+        for line in lines:
+            if line.startswith('Linker script and memory map'):
+                break
+        for line in lines:
+            line = line.rstrip('\n')
+            if not line.strip():
+                continue
+
+            if not line.startswith(' '):
+                match = OUTPUT_SECTION_RE.match(line)
+                output_section = match.group(1) if match else None
+                pending_name = None
+                last = None
+                continue
+
+            if pending_name is not None:
+                match = INPUT_SECTION_CONT_RE.match(line)
+                name, pending_name = pending_name, None
+                if match:
+                    last = add_entry(entries, output_section, name,
+                                     match.group(2), match.group(3))
+                    continue
+
+            match = INPUT_SECTION_RE.match(line)
+            if match and not match.group(1).startswith('0x'):
+                last = add_entry(entries, output_section, match.group(1),
+                                 match.group(3), match.group(4))
+                continue
+
+            match = INPUT_SECTION_NAME_RE.match(line)
+            if match and match.group(1) != '*fill*':
+                pending_name = match.group(1)
+                continue
+
+            match = SYMBOL_RE.match(line)
+            if match and last is not None and last[2] is None:
+                last[2] = match.group(1).strip()
+
+    return [(section, module, symbol_of(name, symbol), size)
+            for section, module, symbol, size, name in entries]
+
+
+def add_entry(entries, output_section, name, size, object_path):
+    size = int(size, 16)
+    if output_section is None or size == 0 or name == '*fill*':
+        return None
+    entry = [output_section, module_of(object_path.strip()), None, size, name]
+    entries.append(entry)
+    return entry
+
+
+def is_flash(section):
+    return section.startswith(FLASH_SECTIONS)
+
+
+def is_ram(section):
+    return section.startswith(RAM_SECTIONS)
+
+
+def read_budgets(config_path):
+    budgets = {}
+    if not os.path.exists(config_path):
+        return budgets
+    with open(config_path, encoding='utf-8') as config_file:
+        config = json.load(config_file).get('config', {})
+    for key in ('flash-budget-bytes', 'ram-budget-bytes'):
+        value = config.get(key)
+        if isinstance(value, dict):
+            value = value.get('value')
+        if value is not None:
+            budgets[key] = int(value)
+    return budgets
+
+
+def write_budgets(config_path, budgets):
+    """Rewrites only the "value" lines of the budget entries, so the rest of
+    mbed_app.json keeps its layout."""
+    with open(config_path, encoding='utf-8') as config_file:
+        text = config_file.read()
+    for key, value in budgets.items():
+        pattern = re.compile(r'("%s"\s*:\s*\{[^}]*?"value"\s*:\s*)\d+'
+                             % re.escape(key))
+        text, count = pattern.subn(r'\g<1>%d' % value, text)
+        if count != 1:
+            raise ValueError('%s not found in %s' % (key, config_path))
+    with open(config_path, 'w', encoding='utf-8') as config_file:
+        config_file.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('map_file')
+    parser.add_argument('--symbols', type=int, default=20,
+                        help='number of largest symbols listed per memory')
+    parser.add_argument('--config', default='mbed_app.json',
+                        help='mbed_app.json holding the budgets')
+    parser.add_argument('--update-budgets', type=int, metavar='PERCENT',
+                        help='set the budgets to this build plus PERCENT')
+    args = parser.parse_args()
+
+    entries = parse_map(args.map_file)
+    modules = collections.defaultdict(lambda: [0, 0])
+    flash_symbols = collections.Counter()
+    ram_symbols = collections.Counter()
+
+    for section, module, symbol, size in entries:
+        if is_flash(section):
+            modules[module][0] += size
+            flash_symbols[(module, symbol)] += size
+        if is_ram(section):
+            modules[module][1] += size
+            ram_symbols[(module, symbol)] += size
+
+    flash_total = sum(m[0] for m in modules.values())
+    ram_total = sum(m[1] for m in modules.values())
+
+    print('%-40s %10s %10s' % ('Module', 'Flash', 'RAM'))
+    for module, (flash, ram) in sorted(modules.items(),
+                                       key=lambda m: (-m[1][1], -m[1][0])):
+        print('%-40s %10d %10d' % (module, flash, ram))
+    print('%-40s %10d %10d' % ('Total', flash_total, ram_total))
+
+    for title, symbols in (('RAM', ram_symbols), ('Flash', flash_symbols)):
+        print('\nLargest %s symbols:' % title)
+        for (module, symbol), size in symbols.most_common(args.symbols):
+            print('%8d  %-28s %s' % (size, module, symbol))
+
+    usage = (('flash-budget-bytes', flash_total),
+             ('ram-budget-bytes', ram_total))
+    if args.update_budgets is not None:
+        write_budgets(args.config, {
+            key: -(-used * (100 + args.update_budgets) // 100 // 1024) * 1024
+            for key, used in usage})
+
+    failed = False
+    budgets = read_budgets(args.config)
+    print()
+    for key, used in usage:
+        if key not in budgets:
+            print('%s: missing from %s' % (key, args.config))
+            failed = True
+            continue
+        status = 'OK'
+        if used > budgets[key]:
+            status = 'EXCEEDED'
+            failed = True
+        print('%s: %d of %d bytes used (%s)' % (key, used, budgets[key],
+                                                status))
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
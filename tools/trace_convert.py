@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Converts a trace dump of the firmware to Chrome trace JSON.
+
+Usage:
+    python3 tools/trace_convert.py capture.bin [-o trace.json]
+    python3 tools/trace_convert.py --port /dev/ttyACM0 [--baud 115200]
+        [-o trace.json]
+
+The firmware must be built with "trace-enabled" set in mbed_app.json, and
+"trace-events" selects the events recorded (the keypad scan is left out by
+default). The 'e' console command dumps the trace ring; the dump is read
+either from a file holding the raw console output or, with --port, straight
+from the serial port after sending 'e' (this needs pyserial).
+
+The output opens in chrome://tracing or https://ui.perfetto.dev: the control
+loop and the interrupts are shown as two threads, with one slice per
+begin/end pair and a marker per instant event. Times come from the DWT cycle
+counter, converted with the CPU clock of the dump header.
+"""
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+HEADER_RE = re.compile(rb'TRACE,(\d+),(\d+),(\d+)\r\n')
+NAME_RE = re.compile(rb'TRACE_NAME,(\d+),([^,\r\n]+),(\w+)\r\n')
+END_MARKER = b'TRACE,END\r\n'
+RECORD = struct.Struct('<IcBH')
+THREADS = {'loop': 1, 'isr': 2}
+CYCLE_COUNTER_RANGE = 1 << 32
+
+
+def parse_dump(data):
+    """Returns the CPU clock, the event names and threads, and the records
+    (cycles, type, event, argument) of the last complete dump in data."""
+    headers = list(HEADER_RE.finditer(data))
+    for header in reversed(headers):
+        cpu_hz, length, number_of_names = (int(g) for g in header.groups())
+        position = header.end()
+        names = {}
+        for _ in range(number_of_names):
+            match = NAME_RE.match(data, position)
+            if not match:
+                break
+            names[int(match.group(1))] = (match.group(2).decode(),
+                                          match.group(3).decode())
+            position = match.end()
+        else:
+            end = position + length * RECORD.size
+            if data[end:end + len(END_MARKER)] != END_MARKER:
+                continue
+            records = [RECORD.unpack_from(data, position + i * RECORD.size)
+                       for i in range(length)]
+            return cpu_hz, names, records
+    raise ValueError('no complete trace dump found')
+
+
+def to_chrome_trace(cpu_hz, names, records):
+    """The cycle counter wraps every 2^32 cycles (about 24 s at 180 MHz);
+    records are in order, so each wrap shows as a smaller count."""
+    events = []
+    wraps = 0
+    previous = None
+    for cycles, event_type, event, argument in records:
+        if previous is not None and cycles < previous:
+            wraps += 1
+        previous = cycles
+        name, thread = names.get(event, ('event %d' % event, 'loop'))
+        chrome_event = {
+            'name': name,
+            'ph': event_type.decode(),
+            'ts': (wraps * CYCLE_COUNTER_RANGE + cycles) * 1e6 / cpu_hz,
+            'pid': 1,
+            'tid': THREADS.get(thread, 1),
+        }
+        if chrome_event['ph'] == 'i':
+            chrome_event['s'] = 't'
+            chrome_event['args'] = {'argument': argument}
+        events.append(chrome_event)
+
+    if events:
+        start = events[0]['ts']
+        for chrome_event in events:
+            chrome_event['ts'] = round(chrome_event['ts'] - start, 3)
+
+    for thread, tid in THREADS.items():
+        events.append({'name': 'thread_name', 'ph': 'M', 'pid': 1,
+                       'tid': tid, 'args': {'name': thread}})
+    return {'traceEvents': events, 'displayTimeUnit': 'ms'}
+
+
+def read_serial(port, baud, timeout):
+    import serial
+
+    data = b''
+    with serial.Serial(port, baud, timeout=timeout) as connection:
+        connection.reset_input_buffer()
+        connection.write(b'e')
+        while END_MARKER not in data:
+            chunk = connection.read(4096)
+            if not chunk:
+                break
+            data += chunk
+    return data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('capture', nargs='?',
+                        help='file holding the raw console output')
+    parser.add_argument('--port', help='serial port to read the dump from')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--timeout', type=float, default=5.0,
+                        help='seconds without data that end the serial read')
+    parser.add_argument('-o', '--output', default='trace.json')
+    args = parser.parse_args()
+
+    if args.port:
+        data = read_serial(args.port, args.baud, args.timeout)
+    elif args.capture:
+        with open(args.capture, 'rb') as capture:
+            data = capture.read()
+    else:
+        parser.error('a capture file or --port is required')
+
+    try:
+        cpu_hz, names, records = parse_dump(data)
+    except ValueError as error:
+        print(error, file=sys.stderr)
+        return 1
+
+    with open(args.output, 'w', encoding='utf-8') as output:
+        json.dump(to_chrome_trace(cpu_hz, names, records), output)
+    print('%d events written to %s' % (len(records), args.output))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())